@@ -14,6 +14,11 @@
  * 
  * @note When disconnected return 0.
  * 
+ * @note Echo pulse is measured by interruptions on both edges of the echo pin, with
+ * microsecond resolution and without blocking the CPU. Several sensors can be ranged
+ * one after the other (round-robin) so their echoes don't cross-talk: the next sensor
+ * is triggered only when the time slot of the previous one has expired.
+ * 
  * @note When ussing dedicated connector in ESP-EDU:
  * |   HC_SR04      |   EDU-CIAA	|
  * |:--------------:|:-------------:|
@@ -29,6 +34,7 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 23/10/2023 | Document creation		                         						|
+ * | 19/10/2026 | Non-blocking ranging and multi-sensor scheduling						|
  * 
  **/
 
@@ -37,8 +43,19 @@
 #include <stdint.h>
 #include "gpio_mcu.h"
 /*==================[macros]=================================================*/
-
+#define HC_SR04_MAX_SENSORS		4	/*!< Maximun number of sensors */
+#define HC_SR04_QUEUE_SIZE		8	/*!< Measures queue size */
+#define HC_SR04_MIN_SLOT_MS		40	/*!< Minimun time slot for each sensor (echo lasts up to 38ms without obstacle) */
 /*==================[typedef]================================================*/
+/**
+ * @brief Measure result
+ */
+typedef struct {
+	uint8_t sensor;			/*!< Sensor index (as returned by HcSr04AddSensor) */
+	uint32_t echo_us;		/*!< Echo pulse width in us (0: no echo, sensor disconnected) */
+	uint16_t distance_mm;	/*!< Measured distance in mm (saturated in maximun distance) */
+	int64_t time_us;		/*!< Trigger time (esp_timer time base) */
+} hc_sr04_measure_t;
 
 /*==================[external data declaration]==============================*/
 
@@ -46,15 +63,64 @@
 /**
  * @brief HC_SR04 initialization.
  * 
+ * @note Removes previously added sensors, the configured one is sensor 0.
+ * 
  * @param echo GPIO number wher echo pin is connected
  * @param trigger GPIO number wher trigger pin is connected
  * @return true 
  */
 bool HcSr04Init(gpio_t echo, gpio_t trigger);
 
+/**
+ * @brief Add another sensor to the round-robin ranging.
+ * 
+ * @param echo GPIO number wher echo pin is connected
+ * @param trigger GPIO number wher trigger pin is connected
+ * @return int8_t sensor index, -1 if there is no room for more sensors
+ */
+int8_t HcSr04AddSensor(gpio_t echo, gpio_t trigger);
+
+/**
+ * @brief Start continuous ranging of all sensors, one at a time.
+ * 
+ * Each sensor is triggered at the beginning of its time slot. Its measure is delivered
+ * at the end of the slot through the measures queue (HcSr04ReadMeasure) and, if not NULL,
+ * the callback function (called from the esp_timer task, it must not block).
+ * 
+ * @param slot_ms Time slot for each sensor (not lower than HC_SR04_MIN_SLOT_MS)
+ * @param func_p Function called with each new measure (can be NULL)
+ * @return true if ranging was started
+ */
+bool HcSr04StartRanging(uint16_t slot_ms, void (*func_p)(const hc_sr04_measure_t *measure));
+
+/**
+ * @brief Stop continuous ranging.
+ */
+void HcSr04StopRanging(void);
+
+/**
+ * @brief Read the next measure of the queue.
+ * 
+ * @param measure Pointer where the measure is stored
+ * @param timeout_ms Maximun time to wait for a measure (0: don't wait)
+ * @return true if a measure was read
+ */
+bool HcSr04ReadMeasure(hc_sr04_measure_t *measure, uint32_t timeout_ms);
+
+/**
+ * @brief Last measured distance of a sensor, without waiting.
+ * 
+ * @param sensor Sensor index
+ * @return uint16_t last measured distance in mm.
+ */
+uint16_t HcSr04LastDistanceInMillimeters(uint8_t sensor);
+
 /**
  * @brief Read distance
  * 
+ * @note Triggers sensor 0 and waits for the echo (the calling task is blocked, not the CPU).
+ * When continuous ranging is running, returns the last measure of sensor 0.
+ * 
  * @return uint16_t measured distance in cm.
  */
 uint16_t HcSr04ReadDistanceInCentimeters(void);
@@ -62,6 +128,8 @@ uint16_t HcSr04ReadDistanceInCentimeters(void);
 /**
  * @brief Read distance
  * 
+ * @note Same as HcSr04ReadDistanceInCentimeters.
+ * 
  * @return uint16_t measured distance in inches.
  */
 uint16_t HcSr04ReadDistanceInInches(void);
@@ -17,26 +17,147 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 30/01/2024 | Document creation		                         						|
+ * | 19/10/2026 | Several devices, data ready interruption and samples buffer			|
+ * | 19/10/2026 | Streaming filter: moving window, outliers, stability and auto-zero	|
  * 
  **/
 
 /*==================[inclusions]=============================================*/
 #include <gpio_mcu.h>
 /*==================[macros]=================================================*/
-
+#define HX711_MAX_DEVICES	2		/*!< Maximun number of HX711 devices */
+#define HX711_BUFFER_SIZE	32		/*!< Samples buffer size for each device (power of 2) */
+#define HX711_WINDOW_SIZE	32		/*!< Maximun moving window size */
 /*==================[typedef]================================================*/
+/**
+ * @brief HX711 sample
+ */
+typedef struct {
+	int32_t value;		/*!< Conversion result (24 bits, signed) */
+	int64_t time_us;	/*!< Data ready time (esp_timer time base) */
+} hx711_sample_t;
+
+/**
+ * @brief Streaming filter configuration (thresholds in scale units)
+ */
+typedef struct {
+	uint8_t window;				/*!< Moving window size (up to HX711_WINDOW_SIZE samples) */
+	float outlier;				/*!< Samples further than this from the window mean are rejected (0: disabled) */
+	uint8_t outlier_qty;		/*!< Consecutive rejected samples taken as a new load (window restarts) */
+	float stable;				/*!< Window standard deviation under which the weight is stable */
+	float zero_band;			/*!< Stable weights inside +/-zero_band are tracked as zero drift (0: disabled) */
+	float zero_rate;			/*!< Fraction of the zero drift corrected with each sample (e.g. 0.01) */
+} hx711_filter_config_t;
+
+/**
+ * @brief Filtered weight
+ */
+typedef struct {
+	float weight;				/*!< Window mean, without tare and divided by scale */
+	float std_dev;				/*!< Window standard deviation (scale units) */
+	bool stable;				/*!< Window full and std_dev below the stable threshold */
+	int64_t time_us;			/*!< Time of the last sample */
+} hx711_weight_t;
 
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
 /** @fn HX711_Init(uint8_t gain, gpio_t pd_sck, gpio_t dout)
  * @brief Define clock and data pin, channel, and gain factor
+ * @note Configures device 0, used by all the functions without device parameter
  * @param[in] gain Gain
  * @param[in] pd_sck Clock pin
  * @param[in] dout Datapin
  */
 void HX711_Init(uint8_t gain, gpio_t pd_sck, gpio_t dout);
 
+/** @fn HX711_InitDevice(uint8_t gain, gpio_t pd_sck, gpio_t dout)
+ * @brief Add a HX711 device
+ * @param[in] gain Gain
+ * @param[in] pd_sck Clock pin
+ * @param[in] dout Datapin
+ * @return Device number, -1 if there is no room for more devices
+ */
+int8_t HX711_InitDevice(uint8_t gain, gpio_t pd_sck, gpio_t dout);
+
+/** @fn HX711_startStream(uint8_t dev)
+ * @brief Start reading the device in the data ready interruption
+ * 
+ * Each conversion is read as soon as DOUT goes low (falling edge interruption) and stored,
+ * with its timestamp, in the device samples buffer. The calling task is never blocked.
+ * @param[in] dev Device number
+ */
+void HX711_startStream(uint8_t dev);
+
+/** @fn HX711_stopStream(uint8_t dev)
+ * @brief Stop reading the device in the data ready interruption
+ * @param[in] dev Device number
+ */
+void HX711_stopStream(uint8_t dev);
+
+/** @fn HX711_readSamples(uint8_t dev, hx711_sample_t *samples, uint16_t max_qty, uint32_t timeout_ms)
+ * @brief Read samples from the device buffer
+ * @param[in] dev Device number
+ * @param[out] samples Pointer where samples are stored (oldest first)
+ * @param[in] max_qty Maximun number of samples to read
+ * @param[in] timeout_ms Maximun time to wait for a sample if buffer is empty (0: don't wait)
+ * @return Number of samples read
+ */
+uint16_t HX711_readSamples(uint8_t dev, hx711_sample_t *samples, uint16_t max_qty, uint32_t timeout_ms);
+
+/** @fn HX711_getOverflows(uint8_t dev)
+ * @brief Samples lost because the buffer was full
+ * @param[in] dev Device number
+ * @return Lost samples
+ */
+uint32_t HX711_getOverflows(uint8_t dev);
+
+/** @fn HX711_filterConfig(uint8_t dev, const hx711_filter_config_t *config)
+ * @brief Configure the streaming filter of a device (window is restarted)
+ * @param[in] dev Device number
+ * @param[in] config Filter configuration
+ */
+void HX711_filterConfig(uint8_t dev, const hx711_filter_config_t *config);
+
+/** @fn HX711_filterUpdate(uint8_t dev, uint32_t timeout_ms)
+ * @brief Feed the streaming filter with the samples of the device buffer
+ * 
+ * Each sample updates the moving window in O(1), whatever the window size.
+ * @param[in] dev Device number (must be streaming)
+ * @param[in] timeout_ms Maximun time to wait for a sample if buffer is empty (0: don't wait)
+ * @return Number of samples processed
+ */
+uint16_t HX711_filterUpdate(uint8_t dev, uint32_t timeout_ms);
+
+/** @fn HX711_getWeight(uint8_t dev, hx711_weight_t *weight)
+ * @brief Last filtered weight, without waiting
+ * @param[in] dev Device number
+ * @param[out] weight Pointer where the weight is stored
+ * @return true if the window has at least one sample
+ */
+bool HX711_getWeight(uint8_t dev, hx711_weight_t *weight);
+
+/** @fn HX711_tareDevice(uint8_t dev)
+ * @brief Set the tare to the current window mean, without waiting new conversions
+ * @param[in] dev Device number
+ */
+void HX711_tareDevice(uint8_t dev);
+
+/** @fn HX711_setDeviceScale(uint8_t dev, float scale)
+ * @brief Set the SCALE value of a device
+ * @param[in] dev Device number
+ * @param[in] scale Scale value
+ */
+void HX711_setDeviceScale(uint8_t dev, float scale);
+
+/** @fn HX711_readRaw(uint8_t dev)
+ * @brief Waits for the chip to be ready and returns a signed reading
+ * @note If the device is streaming, waits for the next sample of the buffer
+ * @param[in] dev Device number
+ * @return Read value (24 bits, signed)
+ */
+int32_t HX711_readRaw(uint8_t dev);
+
 /** @fn int HX711_isReady(void)
  * @brief Check if HX711 is ready
  * @return 1 if ready
@@ -53,7 +174,7 @@ void HX711_setGain(uint8_t gain);
 
 /** @fn HX711_read(void)
  * @brief Waits for the chip to be ready and returns a reading
- * @return Read value
+ * @return Read value (24 bits, offset binary: 0x800000 is 0)
  */
 uint32_t HX711_read(void);
 
@@ -120,10 +241,6 @@ void HX711_powerDown(void);
  */
 void HX711_powerUp(void);
 
-/*==================[internal functions declaration]=========================*/
-// Sends/receives data. 
-uint8_t shiftIn(void);
-
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
@@ -20,6 +20,7 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 05/04/2024 | Document creation		                         						|
+ * | 19/10/2026 | Run-length encoded icons (tools/icon_converter.py)					|
  * 
  **/
 
@@ -100,12 +101,22 @@ typedef enum {
 
 /**
  * @brief  Icon font structure
+ * 
+ * @note Pixels of every icon are run-length encoded in row order (1: foreground):
+ * 
+ * |   Byte(s)   	| Pixels                                    			|
+ * |:--------------:|:------------------------------------------------------|
+ * | 0bbbbbbb	 	| 7 pixels (literal), first one in bit 6				|
+ * | 1cnnnnnn	 	| 8 + n pixels of color c (n < 63)						|
+ * | 1c111111 m	 	| 71 + m pixels of color c								|
+ * 
+ * icons.c is generated with drivers/devices/tools/icon_converter.py.
  */
 typedef struct{
 	uint8_t 		height;   		/*!< Icon height in pixels */
 	uint8_t 		width;			/*!< Icon width in pixels */
-	uint16_t 		offset;			/*!< Offset between icons in data array */
-	const uint8_t 	*data; 			/*!< Icon data array */
+	const uint32_t 	*index;			/*!< Start of every icon in data array */
+	const uint8_t 	*data; 			/*!< Icon data array (run-length encoded) */
 } icon_font_t;
 
 /*==================[external data declaration]==============================*/
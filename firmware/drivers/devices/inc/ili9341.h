@@ -33,11 +33,18 @@
  * |   Date	    | Description                                    |
  * |:----------:|:-----------------------------------------------|
  * | 18/01/2024 | Document creation		                         |
+ * | 19/10/2026 | SPI configured once, pre-built command transfers |
+ * | 19/10/2026 | Optional band framebuffer with dirty rectangles |
+ * | 19/10/2026 | Glyph cache, strings and numeric fields in a single window |
+ * | 19/10/2026 | Span based primitives, thick lines and polylines |
+ * | 19/10/2026 | Icons drawn from run-length encoded data        |
+ * | 19/10/2026 | Streaming decoder for QOI compressed images     |
  *
  */
 
 /*==================[inclusions]=============================================*/
 #include <stdint.h>
+#include <stdbool.h>
 #include "spi_mcu.h"
 #include "fonts.h"
 #include "icons.h"
@@ -46,6 +53,8 @@
 #define ILI9341_WIDTH       240			/*!< LCD width in pixels */
 #define ILI9341_HEIGHT      320			/*!< LCD height in pixels */
 #define ILI9341_PIXEL_MAX	76800
+#define ILI9341_FIELD_MAX_DIGITS	10	/*!< Maximum number of digits of numeric fields */
+#define ILI9341_QOI_HEADER_SIZE		14	/*!< Size of QOI images header */
 /* 16bits colors (RGB565) */			/*	 R,   G,   B */
 #define ILI9341_BLACK          	0x0000  /*   0,   0,   0 */
 #define ILI9341_NAVY           	0x000F 	/*   0,   0, 128 */
@@ -80,6 +89,28 @@ typedef enum ili9341_orientation {
 	ILI9341_Landscape_1, 	/*!< Landscape orientation mode 1 */
 	ILI9341_Landscape_2  	/*!< Landscape orientation mode 2 */
 } ili9341_orientation_t;
+
+/**
+ * @brief  Point of a polyline
+ */
+typedef struct {
+	int16_t x;		/*!< X coordinate */
+	int16_t y;		/*!< Y coordinate */
+} ili9341_point_t;
+
+/**
+ * @brief  Fixed width numeric field (see ILI9341NumFieldInit)
+ */
+typedef struct {
+	uint16_t x;								/*!< X position of top left corner */
+	uint16_t y;								/*!< Y position of top left corner */
+	uint8_t digits;							/*!< Number of digits */
+	uint8_t cell;							/*!< Width of every digit cell (widest digit of font) */
+	Font_t *font;							/*!< Pointer to used font */
+	uint16_t foreground;					/*!< Color for digits (RGB565) */
+	uint16_t background;					/*!< Color for background (RGB565) */
+	char text[ILI9341_FIELD_MAX_DIGITS];	/*!< Digits on screen (driver use) */
+} ili9341_num_field_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -128,7 +159,9 @@ void ILI9341Rotate(ili9341_orientation_t orientation);
 void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background);
 
 /**
- * @brief  		Draw a single character on the LCD
+ * @brief  		Draw an icon on the LCD
+ * @note		Icons are decoded from their run-length encoding straight into the 
+ * 				SPI line buffers, in a single window
  * @param[in]  	x: X position of top left corner
  * @param[in]  	y: Y position of top left corner
  * @param[in] 	icon: Icon to be displayed
@@ -141,6 +174,8 @@ void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font
 
 /**
  * @brief  		Draw an integer on the LCD
+ * @note		Every digit uses a cell as wide as the widest digit of the font, and 
+ * 				all the digits are sent in a single window
  * @param[in]  	x: X position of top left corner
  * @param[in]  	y: Y position of top left corner
  * @param[in] 	num: Number to be displayed
@@ -152,8 +187,36 @@ void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font
  */
 void ILI9341DrawInt(uint16_t x, uint16_t y, uint32_t num, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background);
 
+/**
+ * @brief  		Initializes a fixed width numeric field
+ * @note		Fields are meant for readouts that change often (angle, weight, 
+ * 				heart rate...): ILI9341NumFieldUpdate only sends the digits that changed.
+ * @param[out] 	field: Field to initialize
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in] 	dig: Number of digits to display (up to ILI9341_FIELD_MAX_DIGITS)
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for digits (RGB565)
+ * @param[in]  	background: Color for background (RGB565)
+ * @retval		None
+ */
+void ILI9341NumFieldInit(ili9341_num_field_t *field, uint16_t x, uint16_t y, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Displays a new value in a numeric field
+ * @note		Digits are drawn as in ILI9341DrawInt (same position and leading zeros), 
+ * 				but only the span of digits that differ from the ones on screen is sent.
+ * 				With the band framebuffer enabled the whole field is drawn on every pass.
+ * @param[in]  	field: Field initialized with ILI9341NumFieldInit
+ * @param[in] 	num: Number to be displayed
+ * @retval		None
+ */
+void ILI9341NumFieldUpdate(ili9341_num_field_t *field, uint32_t num);
+
 /**
  * @brief  		Draw a string on the LCD
+ * @note		Each line of the string is sent in a single window, built from a cache 
+ * 				of colorized glyphs (the pixel between characters is drawn with background)
  * @param[in] 	x: X position of top left corner of first character in string
  * @param[in]  	y: Y position of top left corner of first character in string
  * @param[in]  	str: Pointer to first character
@@ -176,6 +239,7 @@ void ILI9341GetStringSize(char* str, Font_t* font, uint16_t* width, uint16_t* he
 
 /**
  * @brief  		Draws line on the LCD
+ * @note		Line is sent as horizontal or vertical runs of pixels (one window per run)
  * @param[in]  	x0: X coordinate of starting point
  * @param[in]  	y0: Y coordinate of starting point
  * @param[in]  	x1: X coordinate of ending point
@@ -185,6 +249,30 @@ void ILI9341GetStringSize(char* str, Font_t* font, uint16_t* width, uint16_t* he
  */
 void ILI9341DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
 
+/**
+ * @brief  		Draws a line of a given thickness on the LCD
+ * @note		Every run of the line is drawn as a single thickness wide span 
+ * 				(clipped to the LCD)
+ * @param[in]  	x0: X coordinate of starting point
+ * @param[in]  	y0: Y coordinate of starting point
+ * @param[in]  	x1: X coordinate of ending point
+ * @param[in]  	y1: Y coordinate of ending point
+ * @param[in]  	thickness: Line thickness in pixels
+ * @param[in]  	color: Line color (RGB565)
+ * @retval 		None
+ */
+void ILI9341DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color);
+
+/**
+ * @brief  		Draws connected lines through a list of points (plot traces, gauges)
+ * @param[in]  	points: Array of points
+ * @param[in]  	qty: Number of points
+ * @param[in]  	thickness: Line thickness in pixels
+ * @param[in]  	color: Line color (RGB565)
+ * @retval 		None
+ */
+void ILI9341DrawPolyline(const ili9341_point_t *points, uint16_t qty, uint8_t thickness, uint16_t color);
+
 /**
  * @brief  		Draws rectangle on the LCD
  * @param[in]  	x0: X coordinate of top left point
@@ -267,6 +355,63 @@ void ILI9341DrawFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, i
  */
 void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pic);
 
+/**
+ * @brief  		Enables the band framebuffer mode
+ * @note		In framebuffer mode primitives draw into a RAM buffer of band_lines 
+ * 				rows instead of the LCD, and the changed areas (dirty rectangles) are 
+ * 				sent by ILI9341Flush with a few large DMA transfers. The screen is 
+ * 				drawn one band at a time: the drawing code is repeated for every band 
+ * 				until ILI9341Flush returns false:
+ * @code
+ * 				do{
+ * 					ILI9341DrawString(10, 10, "Angle:", &font_22, ILI9341_BLACK, ILI9341_WHITE);
+ * 					ILI9341DrawInt(100, 10, angle, 3, &font_22, ILI9341_BLACK, ILI9341_WHITE);
+ * 				} while(ILI9341Flush());
+ * @endcode
+ * @note		Each band is cleared to background before drawing, so pixels not drawn 
+ * 				inside a dirty rectangle are sent with that color.
+ * @param[in]  	band_lines: Rows per band (buffer uses band_lines * 640 bytes)
+ * @param[in]  	background: Color used to clear every band (RGB565)
+ * @retval 		true when success, false when there is not enough memory
+ */
+bool ILI9341FramebufferInit(uint16_t band_lines, uint16_t background);
+
+/**
+ * @brief  		Disables the band framebuffer mode (primitives draw directly on the LCD)
+ * @retval 		None
+ */
+void ILI9341FramebufferDeInit(void);
+
+/**
+ * @brief  		Sends the dirty areas of the current band to the LCD and moves to next band
+ * @retval 		true if there are bands left to draw in this pass, false when the 
+ * 				whole screen was flushed (or framebuffer mode is disabled)
+ */
+bool ILI9341Flush(void);
+
+/**
+ * @brief  		Gets width and height of a QOI compressed image
+ * @param[in] 	qoi: Pointer to first byte of image
+ * @param[in]  	size: Image size in bytes
+ * @param[out]	width: Pointer to variable to store width
+ * @param[out]	height: Pointer to variable to store height
+ * @retval 		true if it is a valid QOI image that fits in the LCD, false otherwise
+ */
+bool ILI9341GetQoiSize(const uint8_t* qoi, uint32_t size, uint16_t* width, uint16_t* height);
+
+/**
+ * @brief  		Draw a QOI (https://qoiformat.org) compressed image on the LCD
+ * @note		Images can be converted with drivers/devices/tools/image_converter.py. 
+ * 				The image is decoded to RGB565 into a line buffer while the previous 
+ * 				one is being sent, so decoding overlaps with SPI transfers.
+ * @param[in] 	x: X position of top left corner of image
+ * @param[in]  	y: Y position of top left corner of image
+ * @param[in]  	qoi: Pointer to first byte of image
+ * @param[in]  	size: Image size in bytes
+ * @retval 		true when success, false if it is not a valid QOI image
+ */
+bool ILI9341DrawQoi(uint16_t x, uint16_t y, const uint8_t* qoi, uint32_t size);
+
 /**
  * @brief  	De-initializes ILI9341 LCD
  * @param	None
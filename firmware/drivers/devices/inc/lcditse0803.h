@@ -30,6 +30,7 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 23/10/2023 | Document creation		                         						|
+ * | 19/10/2026 | BCD pins written with a single masked write							|
  * 
  **/
 
@@ -17,11 +17,18 @@
  * |   Date	| Description                                    			|
  * |:----------:|:----------------------------------------------------------------------|
  * | 30/01/2024 | Document creation		                         		|
+ * | 19/10/2026 | MPU6050_ReadRegister uses the configured address		|
+ * | 19/10/2026 | Optional register cache (MPU6050_setRegisterCache)	|
+ * | 19/10/2026 | FIFO streaming driven by the INT pin (MPU6050_stream*)	|
+ * | 19/10/2026 | Auxiliary bus magnetometer and 9-axis burst read		|
+ * | 19/10/2026 | DMP firmware loading and quaternion output (MPU6050_dmp*)	|
+ * | 19/10/2026 | Motion, zero-motion and free-fall events (MPU6050_events*)	|
  * 
  **/
 
 /*==================[inclusions]=============================================*/
 #include "i2c_mcu.h"
+#include "gpio_mcu.h"
 /*==================[macros]=================================================*/
 #undef pgm_read_byte
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
@@ -409,7 +416,97 @@
 #define MPU6050_DMP_MEMORY_CHUNK_SIZE   16
 // note: DMP code memory blocks defined at end of header file
 
+#define MPU6050_FIFO_SIZE               1024
+#define MPU6050_STREAM_FRAME_SIZE       14  // accel (6), temperature (2) and gyro (6) bytes
+#define MPU6050_STREAM_BUFFER_SIZE      64  // samples ring size (power of 2)
+
+#define MPU6050_EVENT_QUEUE_SIZE        16
+
+#define MPU6050_MOTION9_SIZE            (MPU6050_RA_EXT_SENS_DATA_00 - MPU6050_RA_ACCEL_XOUT_H)    // accel, temp and gyro bytes before external data
+
 /*==================[typedef]================================================*/
+/** Timestamped sample of the streaming mode. */
+typedef struct {
+    int16_t accel[3];       /*!< Raw acceleration (x, y, z) */
+    int16_t temp;           /*!< Raw temperature */
+    int16_t gyro[3];        /*!< Raw angular rate (x, y, z) */
+    int64_t time_us;        /*!< Sample time (esp_timer time base) */
+} mpu6050_sample_t;
+
+/** Magnetometers supported on the auxiliary I2C bus. */
+typedef enum {
+    MPU6050_MAG_NONE = 0,   /*!< No magnetometer */
+    MPU6050_MAG_HMC5883L,   /*!< Honeywell HMC5883L (address 0x1E) */
+    MPU6050_MAG_AK8963      /*!< AKM AK8963 (address 0x0C) */
+} mpu6050_mag_t;
+
+/** Raw 9-axis reading. */
+typedef struct {
+    int16_t accel[3];       /*!< Raw acceleration (x, y, z) */
+    int16_t temp;           /*!< Raw temperature */
+    int16_t gyro[3];        /*!< Raw angular rate (x, y, z) */
+    int16_t mag[3];         /*!< Raw magnetic field (x, y, z) */
+} mpu6050_motion9_t;
+
+/** DMP configuration.
+ * The firmware image (e.g. InvenSense MotionApps) is not part of the driver: the
+ * application provides it along with its FIFO packet layout.
+ */
+typedef struct {
+    const uint8_t *firmware;    /*!< DMP firmware image */
+    uint16_t size;              /*!< Firmware image size in bytes */
+    uint16_t start_address;     /*!< Program start address (e.g. 0x0400 for MotionApps 6.12) */
+    uint8_t packet_size;        /*!< FIFO packet size written by the firmware (e.g. 28 or 42) */
+    uint8_t accel_offset;       /*!< Position of the acceleration in the packet (quaternion is always at 0) */
+    uint8_t rate_divider;       /*!< Sample rate divider (DMP rate = 1 kHz / (1 + rate_divider)) */
+} mpu6050_dmp_config_t;
+
+/** DMP output. */
+typedef struct {
+    float q[4];                 /*!< Orientation quaternion (w, x, y, z) */
+    float gravity[3];           /*!< Gravity direction in the sensor frame (g) */
+    float linear_accel[3];      /*!< Acceleration without gravity in the sensor frame (g) */
+} mpu6050_dmp_data_t;
+
+/** Motion events. */
+typedef enum {
+    MPU6050_EVENT_MOTION,       /*!< Acceleration over the motion threshold */
+    MPU6050_EVENT_STILL,        /*!< Zero motion detected (stillness starts) */
+    MPU6050_EVENT_STILL_END,    /*!< Zero motion ended (stillness ends) */
+    MPU6050_EVENT_FREEFALL      /*!< All axes under the free-fall threshold */
+} mpu6050_event_type_t;
+
+/** Motion event. */
+typedef struct {
+    mpu6050_event_type_t type;  /*!< Event type */
+    uint8_t motion_status;      /*!< MOT_DETECT_STATUS (axis and polarity of the motion) */
+    int64_t time_us;            /*!< INT pin edge time (esp_timer time base) */
+} mpu6050_event_t;
+
+/** Motion events configuration.
+ * Thresholds are in 2 mg (motion, free-fall) or 1 mg (zero motion) units and durations
+ * in ms (zero motion: 64 ms units). A threshold of 0 disables that event.
+ */
+typedef struct {
+    gpio_t int_pin;                 /*!< GPIO connected to the MPU6050 INT pin */
+    uint8_t motion_threshold;       /*!< MOT_THR */
+    uint8_t motion_duration;        /*!< MOT_DUR */
+    uint8_t zero_motion_threshold;  /*!< ZRMOT_THR */
+    uint8_t zero_motion_duration;   /*!< ZRMOT_DUR */
+    uint8_t freefall_threshold;     /*!< FF_THR */
+    uint8_t freefall_duration;      /*!< FF_DUR */
+    bool cycle_mode;                /*!< Low power accelerometer-only cycle mode (only motion events) */
+    uint8_t wake_frequency;         /*!< Cycle mode wake frequency (MPU6050_WAKE_FREQ_*) */
+    uint8_t priority;               /*!< Priority of the task that reads the interrupt status */
+} mpu6050_event_config_t;
+
+/** Streaming mode configuration. */
+typedef struct {
+    gpio_t int_pin;         /*!< GPIO connected to the MPU6050 INT pin */
+    uint16_t rate_hz;       /*!< Sample rate (4 to 1000 Hz, clamped to this range) */
+    uint8_t watermark;      /*!< Samples accumulated in the FIFO before each burst read (1 to 64) */
+    uint8_t priority;       /*!< Priority of the task that reads the FIFO */
+} mpu6050_stream_config_t;
 
 /*==================[external data declaration]==============================*/
 
@@ -422,6 +519,12 @@
  */
 void MPU6050_Address(uint8_t address);
 
+/** Read consecutive registers of the device.
+ * Register address and data are transferred in one repeated start transaction.
+ * @param reg First register address
+ * @param data Buffer to store read data in
+ * @param len Number of bytes to read
+ */
 void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len);
 
 /** Power on and prepare for general usage.
@@ -433,6 +536,18 @@ void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len);
  */
 void MPU6050_initialize();
 
+/** Enable or disable the shadow register cache of the device.
+ * Configuration registers are loaded with one burst read and kept in RAM, so the
+ * MPU6050_set* functions need a single write instead of a read-modify-write.
+ * Data, status and self-clearing registers are always accessed on the bus.
+ * Call it after MPU6050_initialize() (or MPU6050_Address()). Configuration calls placed
+ * between I2C_cacheDefer(address, true) and I2C_cacheCommit(address) are written together
+ * in a few burst transactions.
+ * @param enabled true = enable cache, false = disable cache
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_setRegisterCache(bool enabled);
+
 /** Verify the I2C connection.
  * Make sure the device is connected and responds as expected.
  * @return True if connection is valid, false otherwise
@@ -1818,7 +1933,9 @@ bool MPU6050_getIntDataReadyStatus();
 
 // ACCEL_*OUT_* registers
 /** Get raw 9-axis motion sensor readings (accel/gyro/compass).
- * FUNCTION NOT FULLY IMPLEMENTED YET.
+ * Magnetometer values are 0 until MPU6050_magInit() is called. The outputs are left
+ * untouched if the sensors could not be read.
+ * @see MPU6050_readMotion9()
  * @param ax 16-bit signed integer container for accelerometer X-axis value
  * @param ay 16-bit signed integer container for accelerometer Y-axis value
  * @param az 16-bit signed integer container for accelerometer Z-axis value
@@ -2669,6 +2786,123 @@ uint8_t MPU6050_getDeviceID();
  */
 void MPU6050_setDeviceID(uint8_t id);
 
+// Auxiliary bus magnetometer
+/** Configure a magnetometer on the auxiliary I2C bus.
+ * The magnetometer is configured in continuous mode through the bypass, then the
+ * MPU6050 I2C master is enabled and Slave 0 is set to read the magnetometer data
+ * at the sample rate into EXT_SENS_DATA_00.
+ * @param mag Magnetometer type (MPU6050_MAG_NONE disables Slave 0)
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_magInit(mpu6050_mag_t mag);
+
+/** Read accel, temperature, gyro and magnetometer with a single burst read.
+ * Registers ACCEL_XOUT_H to the last used EXT_SENS_DATA register are read together, so
+ * all values belong to the same sample.
+ * @param data Pointer where readings are stored
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_readMotion9(mpu6050_motion9_t *data);
+
+// DMP
+/** Write a block to the DMP memory.
+ * The block is written in MPU6050_DMP_MEMORY_CHUNK_SIZE bytes bursts, moving to the
+ * next memory bank when needed.
+ * @param data Data to write
+ * @param size Number of bytes
+ * @param bank First memory bank
+ * @param address Start address in the memory bank
+ * @param verify Read back every chunk and compare it
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_writeMemoryBlock(const uint8_t *data, uint16_t size, uint8_t bank, uint8_t address, bool verify);
+
+/** Read a block from the DMP memory.
+ * @param data Buffer to store read data in
+ * @param size Number of bytes
+ * @param bank First memory bank
+ * @param address Start address in the memory bank
+ * @return Status of operation (true = success)
+ */
+bool MPU6050_readMemoryBlock(uint8_t *data, uint16_t size, uint8_t bank, uint8_t address);
+
+/** Load the DMP firmware and start the DMP.
+ * The device is reset, configured (gyro +/-2000 deg/s, DLPF 42 Hz, sample rate divider),
+ * the firmware is loaded and verified, the program start address is set, and the FIFO
+ * and DMP are enabled.
+ * @param config DMP configuration (the firmware image must remain valid)
+ * @return Status of operation (false if the stream or the events are running)
+ */
+bool MPU6050_dmpInitialize(const mpu6050_dmp_config_t *config);
+
+/** Set the DMP enabled status.
+ * @param enabled New DMP enabled status
+ */
+void MPU6050_setDMPEnabled(bool enabled);
+
+/** Read the latest DMP packet from the FIFO.
+ * Older packets are discarded. A FIFO overflow resets the FIFO.
+ * @param data Quaternion, gravity and gravity-compensated acceleration
+ * @return true if a new packet was read
+ */
+bool MPU6050_dmpRead(mpu6050_dmp_data_t *data);
+
+// Motion events
+/** Start delivering motion events.
+ * Thresholds and durations are configured, and the INT pin is latched until the status
+ * is read. The pin interruption wakes a task that reads INT_STATUS and MOT_DETECT_STATUS
+ * in one transaction and queues the events (read them with MPU6050_eventRead()). In
+ * cycle mode the gyroscopes are put in standby and the accelerometer is sampled at the
+ * wake frequency.
+ * @param config Events configuration
+ * @return Status of operation (false if the stream or the DMP is running)
+ */
+bool MPU6050_eventsStart(const mpu6050_event_config_t *config);
+
+/** Stop delivering motion events (interruptions and cycle mode are disabled). */
+void MPU6050_eventsStop();
+
+/** Read the next motion event.
+ * @param event Pointer where the event is stored
+ * @param timeout_ms Maximum time to wait for an event (0 = don't wait)
+ * @return true if an event was read
+ */
+bool MPU6050_eventRead(mpu6050_event_t *event, uint32_t timeout_ms);
+
+/** Put the MCU in light sleep until the INT pin rises.
+ * Events must be started. The event that woke up the MCU is then delivered as usual.
+ * @param max_ms Maximum sleep time (0 = only the INT pin wakes up)
+ */
+void MPU6050_eventsSleep(uint32_t max_ms);
+
+// Streaming mode
+/** Start sampling into the FIFO and reading it in bursts.
+ * The sample rate divider, DLPF and FIFO contents (accel, temperature and gyro) are
+ * configured, and the INT pin is set to pulse on each data ready. The pin interruption
+ * only counts samples: every config->watermark samples a task reads all the complete
+ * frames in the FIFO with a few burst reads and stores them, timestamped, in a ring.
+ * A FIFO overflow (or a misaligned frame count) resets the FIFO and restarts the stream.
+ * @param config Streaming configuration
+ * @return Status of operation (false if the events or the DMP are running)
+ */
+bool MPU6050_streamStart(const mpu6050_stream_config_t *config);
+
+/** Stop the streaming mode (FIFO and data ready interruption are disabled). */
+void MPU6050_streamStop();
+
+/** Read samples from the streaming ring.
+ * @param samples Array where samples are stored (oldest first)
+ * @param max_qty Maximum number of samples to read
+ * @param timeout_ms Maximum time to wait if the ring is empty (0 = don't wait)
+ * @return Number of samples read
+ */
+uint16_t MPU6050_streamRead(mpu6050_sample_t *samples, uint16_t max_qty, uint32_t timeout_ms);
+
+/** Samples lost by FIFO overflow or because the ring was full.
+ * @return Lost samples count
+ */
+uint32_t MPU6050_streamOverflows();
+
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
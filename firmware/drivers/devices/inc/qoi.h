@@ -0,0 +1,82 @@
+#ifndef QOI_H_
+#define QOI_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Drivers_Devices Drivers devices
+ ** @{ */
+/** \addtogroup QOI QOI decoder
+ ** @{ */
+
+/** \brief Streaming decoder for QOI (https://qoiformat.org) compressed images.
+ *
+ * Pixels are decoded into RGB565 (high byte first, as sent to the LCD) in strips of any
+ * number of pixels, so an image can be drawn with small buffers. It has no hardware
+ * dependencies (used by ili9341.c and by the host tests).
+ *
+ * @author Eric Beauchamps
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 19/10/2026 | Document creation		                         						|
+ *
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+/*==================[macros]=================================================*/
+#define QOI_HEADER_SIZE		14		/*!< Size of QOI images header */
+#define QOI_PADDING			8		/*!< Bytes of the QOI end marker */
+
+/*==================[typedef]================================================*/
+/**
+ * @brief QOI image decoder state
+ */
+typedef struct {
+	const uint8_t *data;		/*!< Next byte of encoded data */
+	const uint8_t *end;			/*!< End of encoded data (start of end marker) */
+	uint8_t px[4];				/*!< Previous color (r, g, b, a) */
+	uint8_t index[64][4];		/*!< Previously seen colors */
+	uint8_t run;				/*!< Pixels left of current run */
+} qoi_decoder_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief  		Gets width and height of a QOI compressed image
+ * @param[in] 	qoi: Pointer to first byte of image
+ * @param[in] 	size: Size of image in bytes
+ * @param[out] 	width: Image width in pixels
+ * @param[out] 	height: Image height in pixels
+ * @retval 		true if it is a valid QOI image header, false otherwise
+ */
+bool QoiGetSize(const uint8_t* qoi, uint32_t size, uint32_t* width, uint32_t* height);
+
+/**
+ * @brief  		Prepares a decoder for an image (the image must remain valid while decoding)
+ * @param[out] 	dec: Decoder state
+ * @param[in] 	qoi: Pointer to first byte of image
+ * @param[in] 	size: Size of image in bytes
+ * @retval 		true if it is a valid QOI image, false otherwise
+ */
+bool QoiDecoderInit(qoi_decoder_t *dec, const uint8_t* qoi, uint32_t size);
+
+/**
+ * @brief  		Decode the next pixels of a QOI image into RGB565 (high byte first)
+ * @note		If encoded data ends before, remaining pixels repeat the last color
+ * @param[in]  	dec: Decoder state
+ * @param[out] 	dst: Destination (2 bytes/pixel)
+ * @param[in]  	pixels: Number of pixels to decode
+ * @retval 		None
+ */
+void QoiDecode(qoi_decoder_t *dec, uint8_t *dst, uint32_t pixels);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* QOI_H_ */
+
+/*==================[end of file]============================================*/
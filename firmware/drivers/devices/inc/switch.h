@@ -19,6 +19,7 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 23/10/2023 | Document creation		                         						|
+ * | 19/10/2026 | Interrupt-driven debounce and switch events							|
  * 
  **/
 
@@ -26,12 +27,37 @@
 #include <stdbool.h>
 #include <stdint.h>
 /*==================[macros]=================================================*/
+#define SWITCH_DEBOUNCE_MS		20		/**< Time a switch must be stable to accept a change */
+#define SWITCH_LONG_PRESS_MS	1000	/**< Time held to generate a long press event */
+#define SWITCH_REPEAT_MS		200		/**< Repeat events period after a long press */
+#define SWITCH_DOUBLE_CLICK_MS	300		/**< Maximum time between a release and the next press for a double click */
+#define SWITCH_EVENT_QUEUE_SIZE	16		/**< Pending events */
 
 /*==================[typedef]================================================*/
 typedef enum switches {
     SWITCH_1 = (1 << 0),  /**< Routed to GPIO_4 */
     SWITCH_2 = (1 << 1),  /**< Routed to GPIO_15 */
 } switch_t;
+
+/**
+ * @brief Switch event types
+ */
+typedef enum {
+	SWITCH_PRESS,			/**< Switch pressed (after debounce) */
+	SWITCH_RELEASE,			/**< Switch released (after debounce) */
+	SWITCH_LONG_PRESS,		/**< Switch held for SWITCH_LONG_PRESS_MS */
+	SWITCH_REPEAT,			/**< Switch still held, every SWITCH_REPEAT_MS after a long press */
+	SWITCH_DOUBLE_CLICK,	/**< Second short press within SWITCH_DOUBLE_CLICK_MS */
+} switch_event_type_t;
+
+/**
+ * @brief Switch event
+ */
+typedef struct {
+	switch_t sw;				/**< Switch */
+	switch_event_type_t type;	/**< Event type */
+	uint32_t time_ms;			/**< Event time (ms since scheduler start) */
+} switch_event_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -58,6 +84,28 @@ int8_t SwitchesRead(void);
  */
 void SwitchActivInt(switch_t tec, void *ptrIntFunc, void *args);
 
+/**
+ * @brief Start the switch events engine.
+ * 
+ * Edges of both switches restart a debounce timer, and the stable state is used to
+ * generate press, release, long press, repeat and double click events. Switches are not
+ * polled: the timer only runs after an edge or while a switch is held.
+ * 
+ * @note SwitchesInit() must be called first. Don't use it together with SwitchActivInt().
+ * 
+ * @return true if the engine could be started
+ */
+bool SwitchEventsInit(void);
+
+/**
+ * @brief Wait for the next switch event.
+ * 
+ * @param event Received event
+ * @param timeout_ms Maximum time to wait (portMAX_DELAY to wait forever)
+ * @return true if an event was received
+ */
+bool SwitchEventRead(switch_event_t *event, uint32_t timeout_ms);
+
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
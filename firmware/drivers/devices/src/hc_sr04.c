@@ -12,6 +12,12 @@
 /*==================[inclusions]=============================================*/
 #include "hc_sr04.h"
 #include "delay_mcu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "soc/gpio_reg.h"
 /*==================[macros and definitions]=================================*/
 #define MAX_US		17700	/* maximun distance time in us (300cm or 118inch) */
 #define MAX_CM		300		/* maximun distance time in cm */
@@ -19,74 +25,245 @@
 #define US2CM		59		/* scale factor to conver pulse width to cm */
 #define US2INCH		150		/* scale factor to conver pulse width to inch */
 #define WAIT_MAX	5900	/* maximun time to wait for echo signal */
+#define TRIGGER_US	10		/* trigger pulse width */
 /*==================[internal data declaration]==============================*/
-static gpio_t echo_st, trigger_st; /**<  Stores the pin inicilization*/
+/**
+ * @brief Echo measure state
+ */
+typedef enum {
+	ECHO_IDLE,			/*!< Sensor not triggered */
+	ECHO_WAIT_RISE,		/*!< Triggered, waiting echo rising edge */
+	ECHO_WAIT_FALL,		/*!< Echo pulse in progress */
+	ECHO_DONE			/*!< Echo pulse measured */
+} echo_state_t;
+
+/**
+ * @brief Sensor data
+ */
+typedef struct {
+	gpio_t echo;					/*!< Echo pin */
+	gpio_t trigger;					/*!< Trigger pin */
+	volatile echo_state_t state;	/*!< Echo measure state */
+	volatile int64_t rise_us;		/*!< Echo rising edge time */
+	volatile uint32_t echo_us;		/*!< Echo pulse width */
+	int64_t trigger_us;				/*!< Trigger time */
+	uint16_t last_mm;				/*!< Last measured distance */
+} hc_sr04_sensor_t;
 /*==================[internal functions declaration]=========================*/
 
 /*==================[internal data definition]===============================*/
-
+static hc_sr04_sensor_t sensors[HC_SR04_MAX_SENSORS];
+static uint8_t sensors_qty = 0;
+static uint8_t current_sensor = 0;
+static QueueHandle_t measures_queue = NULL;
+static SemaphoreHandle_t echo_done = NULL;
+static esp_timer_handle_t ranging_timer = NULL;
+static bool ranging = false;
+static void (*ranging_func_p)(const hc_sr04_measure_t *measure) = NULL;
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Echo pin interruption (both edges): pulse width with us resolution
+ */
+static void IRAM_ATTR HcSr04EchoIsr(void *args){
+	hc_sr04_sensor_t *sensor = args;
+	int64_t now = esp_timer_get_time();
+	BaseType_t higher_priority_task_woken = pdFALSE;
+	bool level = (REG_READ(GPIO_IN_REG) >> sensor->echo) & 1;
+
+	if(level && sensor->state == ECHO_WAIT_RISE){
+		sensor->rise_us = now;
+		sensor->state = ECHO_WAIT_FALL;
+	}
+	else if(!level && sensor->state == ECHO_WAIT_FALL){
+		sensor->echo_us = (uint32_t)(now - sensor->rise_us);
+		sensor->state = ECHO_DONE;
+		xSemaphoreGiveFromISR(echo_done, &higher_priority_task_woken);
+	}
+	portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/**
+ * @brief Start a measure of a sensor
+ */
+static void HcSr04Trigger(hc_sr04_sensor_t *sensor){
+	sensor->echo_us = 0;
+	sensor->state = ECHO_WAIT_RISE;
+	GPIOOn(sensor->trigger);
+	DelayUs(TRIGGER_US);
+	GPIOOff(sensor->trigger);
+	sensor->trigger_us = esp_timer_get_time();
+}
+
+/**
+ * @brief Finish the measure of a sensor
+ * 
+ * Echo still in progress means no obstacle in range: saturated in maximun distance.
+ * No echo at all means sensor disconnected: 0.
+ */
+static void HcSr04Finish(uint8_t index, hc_sr04_measure_t *measure){
+	hc_sr04_sensor_t *sensor = &sensors[index];
+	uint32_t echo_us;
+
+	switch(sensor->state){
+		case ECHO_DONE:
+			echo_us = sensor->echo_us;
+		break;
+		case ECHO_WAIT_FALL:
+			echo_us = MAX_US;
+		break;
+		default:
+			echo_us = 0;
+		break;
+	}
+	sensor->state = ECHO_IDLE;
+	if(echo_us > MAX_US){
+		echo_us = MAX_US;
+	}
+	measure->sensor = index;
+	measure->echo_us = echo_us;
+	measure->distance_mm = echo_us * 10 / US2CM;
+	measure->time_us = sensor->trigger_us;
+	sensor->last_mm = measure->distance_mm;
+}
+
+/**
+ * @brief End of a sensor time slot: deliver its measure and trigger the next one
+ */
+static void HcSr04RangingTimer(void *args){
+	hc_sr04_measure_t measure;
+
+	if(sensors[current_sensor].state != ECHO_IDLE){
+		HcSr04Finish(current_sensor, &measure);
+		if(xQueueSend(measures_queue, &measure, 0) != pdTRUE){
+			/* Queue full: oldest measure is discarded */
+			hc_sr04_measure_t old;
+			xQueueReceive(measures_queue, &old, 0);
+			xQueueSend(measures_queue, &measure, 0);
+		}
+		if(ranging_func_p != NULL){
+			ranging_func_p(&measure);
+		}
+		current_sensor = (current_sensor + 1) % sensors_qty;
+	}
+	if(ranging){
+		HcSr04Trigger(&sensors[current_sensor]);
+	}
+}
+
+/**
+ * @brief Single measure of sensor 0, blocking only the calling task
+ */
+static uint32_t HcSr04ReadEcho(void){
+	hc_sr04_measure_t measure;
+	if(ranging){
+		return (uint32_t)sensors[0].last_mm * US2CM / 10;
+	}
+	xSemaphoreTake(echo_done, 0);
+	HcSr04Trigger(&sensors[0]);
+	/* Echo pulse starts up to WAIT_MAX us after trigger and lasts up to MAX_US */
+	xSemaphoreTake(echo_done, pdMS_TO_TICKS((WAIT_MAX + MAX_US) / 1000 + 2));
+	HcSr04Finish(0, &measure);
+	return measure.echo_us;
+}
 
 /*==================[external functions definition]==========================*/
 
 bool HcSr04Init(gpio_t echo, gpio_t trigger){
-	echo_st = echo;
-	trigger_st = trigger;
+	HcSr04StopRanging();
+	if(echo_done == NULL){
+		echo_done = xSemaphoreCreateBinary();
+		measures_queue = xQueueCreate(HC_SR04_QUEUE_SIZE, sizeof(hc_sr04_measure_t));
+	}
+	for(uint8_t i = 0; i < sensors_qty; i++){
+		GPIODeactivInt(sensors[i].echo);
+	}
+	sensors_qty = 0;
+	return HcSr04AddSensor(echo, trigger) == 0;
+}
+
+int8_t HcSr04AddSensor(gpio_t echo, gpio_t trigger){
+	hc_sr04_sensor_t *sensor;
+	if(sensors_qty >= HC_SR04_MAX_SENSORS || echo_done == NULL){
+		return -1;
+	}
+	sensor = &sensors[sensors_qty];
+	sensor->echo = echo;
+	sensor->trigger = trigger;
+	sensor->state = ECHO_IDLE;
+	sensor->last_mm = 0;
 
 	/** Configuration of the GPIO pins*/
 	GPIOInit(echo, GPIO_INPUT);
 	GPIOInit(trigger, GPIO_OUTPUT);
+	GPIOActivIntAnyEdge(echo, HcSr04EchoIsr, sensor);
 
-	return true;
+	return sensors_qty++;
 }
 
-uint16_t HcSr04ReadDistanceInCentimeters(void){
-	uint16_t distance = 0, waiting = 0;
-	GPIOOn(trigger_st);
-	DelayUs(10);
-	GPIOOff(trigger_st);
-	while(!GPIORead(echo_st)){
-		DelayUs(10);
-		waiting += 10;
-		if(waiting > WAIT_MAX){
-			return 0;
-		}
+bool HcSr04StartRanging(uint16_t slot_ms, void (*func_p)(const hc_sr04_measure_t *measure)){
+	esp_timer_create_args_t timer_args = {
+		.callback = HcSr04RangingTimer,
+		.name = "hc_sr04",
+	};
+	if(sensors_qty == 0 || ranging){
+		return false;
 	}
-	do{
-		DelayUs(10);
-		distance += 10;
-		if(distance > MAX_US)
-			return MAX_CM;
+	if(slot_ms < HC_SR04_MIN_SLOT_MS){
+		slot_ms = HC_SR04_MIN_SLOT_MS;
 	}
-	while(GPIORead(echo_st));
-	return (distance/US2CM);
+	if(ranging_timer == NULL){
+		if(esp_timer_create(&timer_args, &ranging_timer) != ESP_OK){
+			return false;
+		}
+	}
+	ranging_func_p = func_p;
+	current_sensor = 0;
+	ranging = true;
+	HcSr04Trigger(&sensors[current_sensor]);
+	esp_timer_start_periodic(ranging_timer, (uint64_t)slot_ms * 1000);
+	return true;
 }
 
-uint16_t HcSr04ReadDistanceInInches(void){
-	uint16_t distance = 0, waiting = 0;
-	GPIOOn(trigger_st);
-	DelayUs(10);
-	GPIOOff(trigger_st);
-	while(!GPIORead(echo_st)){
-		DelayUs(10);
-		waiting += 10;
-		if(waiting > WAIT_MAX){
-			return 0;
+void HcSr04StopRanging(void){
+	if(ranging){
+		ranging = false;
+		esp_timer_stop(ranging_timer);
+		for(uint8_t i = 0; i < sensors_qty; i++){
+			sensors[i].state = ECHO_IDLE;
 		}
 	}
-	do{
-		DelayUs(10);
-		distance += 10;
-		if(distance > MAX_US)
-			return MAX_INCH;
+}
+
+bool HcSr04ReadMeasure(hc_sr04_measure_t *measure, uint32_t timeout_ms){
+	if(measures_queue == NULL){
+		return false;
+	}
+	return xQueueReceive(measures_queue, measure, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+uint16_t HcSr04LastDistanceInMillimeters(uint8_t sensor){
+	if(sensor >= sensors_qty){
+		return 0;
 	}
-	while(GPIORead(echo_st));
-	return (distance/US2INCH);
+	return sensors[sensor].last_mm;
+}
+
+uint16_t HcSr04ReadDistanceInCentimeters(void){
+	return (HcSr04ReadEcho()/US2CM);
+}
+
+uint16_t HcSr04ReadDistanceInInches(void){
+	return (HcSr04ReadEcho()/US2INCH);
 }
 
 bool HcSr04Deinit(void){
+	HcSr04StopRanging();
+	for(uint8_t i = 0; i < sensors_qty; i++){
+		GPIODeactivInt(sensors[i].echo);
+	}
+	sensors_qty = 0;
 	GPIODeinit();
 	return true;
 }
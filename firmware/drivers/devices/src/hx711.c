@@ -8,110 +8,426 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <math.h>
 
 #include "hx711.h"
 
 #include <delay_mcu.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "soc/gpio_reg.h"
+#include "sdkconfig.h"
 
 /*==================[macros and definitions]=================================*/
+#define DATA_BITS		24												/*!< Conversion result bits */
+#define CLK_CYCLES		(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 2)			/*!< PD_SCK half period: 0.5us (min 0.2us, max 50us) */
+#define BUFFER_MASK		(HX711_BUFFER_SIZE - 1)
 
 /*==================[internal data declaration]==============================*/
-uint8_t GAIN;		             /*!<  Amplification factor */
-double OFFSET;	                 /*!<  Used for tare weight */
-float SCALE;	                 /*!<  Used to return weight in grams, kg, ounces, whatever */ 
-
-
-gpio_t internal_pd_sck;
-gpio_t internal_dout;
+/**
+ * @brief HX711 device data
+ */
+typedef struct {
+	gpio_t pd_sck;							/*!< Clock pin */
+	gpio_t dout;							/*!< Data pin */
+	uint8_t gain;							/*!< Extra PD_SCK pulses: amplification factor for next conversion */
+	double offset;							/*!< Used for tare weight */
+	float scale;							/*!< Used to return weight in grams, kg, ounces, whatever */
+	bool streaming;							/*!< Device read in data ready interruption */
+	hx711_sample_t buffer[HX711_BUFFER_SIZE];	/*!< Samples buffer */
+	volatile uint16_t head;					/*!< Buffer write index (written only by ISR) */
+	volatile uint16_t tail;					/*!< Buffer read index (written only by task) */
+	volatile uint32_t overflows;			/*!< Samples lost because the buffer was full */
+	SemaphoreHandle_t available;			/*!< Given when the buffer stops being empty */
+	hx711_filter_config_t filter;			/*!< Streaming filter configuration */
+	int32_t window[HX711_WINDOW_SIZE];		/*!< Moving window samples */
+	uint8_t window_qty;						/*!< Samples in the window */
+	uint8_t window_index;					/*!< Next window position to replace */
+	int64_t sum;							/*!< Window samples sum */
+	int64_t sum_sq;							/*!< Window samples squares sum */
+	uint8_t rejected;						/*!< Consecutive rejected samples */
+	hx711_weight_t weight;					/*!< Last filtered weight */
+} hx711_device_t;
 
 /*==================[internal functions declaration]=========================*/
 
-uint8_t shiftIn(void)
-{
-    uint8_t value = 0;
-
-    for (uint8_t i = 0; i < 8; ++i)
-    {
-    	GPIOOn(internal_pd_sck);//PD_SCK_SET_HIGH;
-        value |= GPIORead(internal_dout) << (7 - i);
-        GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
-    }
-    return value;
-}
+/*==================[internal data definition]===============================*/
+static hx711_device_t devices[HX711_MAX_DEVICES];
+static uint8_t devices_qty = 0;
+static portMUX_TYPE hx711_mux = portMUX_INITIALIZER_UNLOCKED;
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Busy wait a number of CPU cycles (no function calls, no timers)
+ */
+static inline void IRAM_ATTR HX711Wait(uint32_t cycles)
+{
+	uint32_t start = esp_cpu_get_cycle_count();
+	while((esp_cpu_get_cycle_count() - start) < cycles);
+}
 
-/*==================[external functions definition]==========================*/
-void HX711_Init(uint8_t gain, gpio_t pd_sck, gpio_t dout)
+/**
+ * @brief Clocks out a conversion (24 bits plus gain pulses)
+ * 
+ * PD_SCK high time over 60us would power down the chip, so pulses are generated
+ * with interruptions disabled (about 30us at 0.5us half period).
+ */
+static int32_t IRAM_ATTR HX711ShiftIn(hx711_device_t *device)
 {
-	internal_pd_sck = pd_sck;
-	internal_dout = dout;
-	GPIOInit(pd_sck, GPIO_OUTPUT);//PD_SCK_SET_OUTPUT;
-	GPIOInit(dout, GPIO_INPUT);//DOUT_SET_INPUT;
-    HX711_setGain(gain);
+	uint32_t sck = 1UL << device->pd_sck;
+	uint32_t dout = 1UL << device->dout;
+	uint32_t count = 0;
 
+	portENTER_CRITICAL_SAFE(&hx711_mux);
+	for(uint8_t i = 0; i < DATA_BITS; i++)
+	{
+		REG_WRITE(GPIO_OUT_W1TS_REG, sck);
+		HX711Wait(CLK_CYCLES);
+		REG_WRITE(GPIO_OUT_W1TC_REG, sck);
+		HX711Wait(CLK_CYCLES);
+		count = (count << 1) | ((REG_READ(GPIO_IN_REG) & dout) != 0);
+	}
+	for(uint8_t i = 0; i < device->gain; i++)
+	{
+		REG_WRITE(GPIO_OUT_W1TS_REG, sck);
+		HX711Wait(CLK_CYCLES);
+		REG_WRITE(GPIO_OUT_W1TC_REG, sck);
+		HX711Wait(CLK_CYCLES);
+	}
+	portEXIT_CRITICAL_SAFE(&hx711_mux);
+	/* Sign extension of the 24 bits two's complement result */
+	return ((int32_t)(count << 8)) >> 8;
 }
 
-int HX711_isReady(void)
+/**
+ * @brief DOUT falling edge: conversion ready
+ */
+static void IRAM_ATTR HX711DataReadyIsr(void *args)
 {
-    return (GPIORead(internal_dout)) == 0;
+	hx711_device_t *device = args;
+	BaseType_t higher_priority_task_woken = pdFALSE;
+	int64_t now = esp_timer_get_time();
+	uint16_t head = device->head;
+
+	/* DOUT toggles while clocking data out: those edges find it high again */
+	if(REG_READ(GPIO_IN_REG) & (1UL << device->dout))
+	{
+		return;
+	}
+	int32_t value = HX711ShiftIn(device);
+	if(((head + 1) & BUFFER_MASK) == device->tail)
+	{
+		device->overflows++;
+		return;
+	}
+	device->buffer[head].value = value;
+	device->buffer[head].time_us = now;
+	device->head = (head + 1) & BUFFER_MASK;
+	if(head == device->tail)
+	{
+		xSemaphoreGiveFromISR(device->available, &higher_priority_task_woken);
+	}
+	portYIELD_FROM_ISR(higher_priority_task_woken);
 }
 
-void HX711_setGain(uint8_t gain)
+/**
+ * @brief Set the extra PD_SCK pulses; takes effect after the next conversion is read
+ */
+static void HX711SetGain(hx711_device_t *device, uint8_t gain)
 {
 	switch (gain)
 	{
 		case 128:		// channel A, gain factor 128
-			GAIN = 1;
+			device->gain = 1;
 			break;
 		case 64:		// channel A, gain factor 64
-			GAIN = 3;
+			device->gain = 3;
 			break;
 		case 32:		// channel B, gain factor 32
-			GAIN = 2;
+			device->gain = 2;
 			break;
 	}
+}
+
+/**
+ * @brief Restart the moving window
+ */
+static void HX711FilterReset(hx711_device_t *device)
+{
+	device->window_qty = 0;
+	device->window_index = 0;
+	device->sum = 0;
+	device->sum_sq = 0;
+	device->rejected = 0;
+	portENTER_CRITICAL(&hx711_mux);
+	device->weight.stable = false;
+	portEXIT_CRITICAL(&hx711_mux);
+}
+
+/**
+ * @brief Add a sample to the streaming filter
+ */
+static void HX711FilterSample(hx711_device_t *device, const hx711_sample_t *sample)
+{
+	hx711_filter_config_t *filter = &device->filter;
+	float scale = (device->scale != 0) ? device->scale : 1;
+	double mean, variance;
+	hx711_weight_t weight;
+	/* Same offset binary values as HX711_read, so OFFSET is shared with HX711_tare */
+	int32_t value = sample->value + 0x800000;
+	int32_t old;
+
+	if(filter->outlier > 0 && device->window_qty == filter->window)
+	{
+		mean = (double)device->sum / device->window_qty;
+		if(fabs((value - mean) / scale) > filter->outlier)
+		{
+			/* A persistent step is a new load, not an outlier */
+			if(++device->rejected < filter->outlier_qty)
+			{
+				return;
+			}
+			HX711FilterReset(device);
+		}
+	}
+	device->rejected = 0;
+	/* Running sums: the oldest sample leaves the window as the new one enters */
+	if(device->window_qty == filter->window)
+	{
+		old = device->window[device->window_index];
+		device->sum -= old;
+		device->sum_sq -= (int64_t)old * old;
+	}
+	else
+	{
+		device->window_qty++;
+	}
+	device->window[device->window_index] = value;
+	device->sum += value;
+	device->sum_sq += (int64_t)value * value;
+	device->window_index = (device->window_index + 1) % filter->window;
+
+	mean = (double)device->sum / device->window_qty;
+	/* Exact in 64 bits (24 bits samples, up to 32 samples): no cancellation error */
+	variance = (double)(device->window_qty * device->sum_sq - device->sum * device->sum) / ((int32_t)device->window_qty * device->window_qty);
+	weight.std_dev = (variance > 0) ? sqrt(variance) / fabs(scale) : 0;
+	weight.stable = (device->window_qty == filter->window) && (weight.std_dev < filter->stable);
+	weight.weight = (mean - device->offset) / scale;
+	weight.time_us = sample->time_us;
+	/* Slow zero drift tracking while unloaded and settled */
+	if(weight.stable && filter->zero_band > 0 && fabs(weight.weight) < filter->zero_band)
+	{
+		device->offset += (mean - device->offset) * filter->zero_rate;
+		weight.weight = (mean - device->offset) / scale;
+	}
+	/* Published at once, so HX711_getWeight never sees a half updated result */
+	portENTER_CRITICAL(&hx711_mux);
+	device->weight = weight;
+	portEXIT_CRITICAL(&hx711_mux);
+}
+
+/*==================[external functions definition]==========================*/
+void HX711_Init(uint8_t gain, gpio_t pd_sck, gpio_t dout)
+{
+	for(uint8_t i = 0; i < devices_qty; i++)
+	{
+		HX711_stopStream(i);
+	}
+	devices_qty = 0;
+	HX711_InitDevice(gain, pd_sck, dout);
+}
+
+int8_t HX711_InitDevice(uint8_t gain, gpio_t pd_sck, gpio_t dout)
+{
+	hx711_device_t *device;
+	if(devices_qty >= HX711_MAX_DEVICES)
+	{
+		return -1;
+	}
+	device = &devices[devices_qty];
+	device->pd_sck = pd_sck;
+	device->dout = dout;
+	device->offset = 0;
+	device->scale = 1;
+	device->streaming = false;
+	device->head = 0;
+	device->tail = 0;
+	device->overflows = 0;
+	device->filter.window = HX711_WINDOW_SIZE / 4;
+	device->filter.outlier = 0;
+	device->filter.outlier_qty = 0;
+	device->filter.stable = 0;
+	device->filter.zero_band = 0;
+	device->filter.zero_rate = 0;
+	HX711FilterReset(device);
+	if(device->available == NULL)
+	{
+		device->available = xSemaphoreCreateBinary();
+	}
+	GPIOInit(pd_sck, GPIO_OUTPUT);//PD_SCK_SET_OUTPUT;
+	GPIOInit(dout, GPIO_INPUT);//DOUT_SET_INPUT;
+	GPIOOff(pd_sck);//PD_SCK_SET_LOW;
+	HX711SetGain(device, gain);
+	devices_qty++;
+	HX711_readRaw(devices_qty - 1);
+	return devices_qty - 1;
+}
+
+void HX711_startStream(uint8_t dev)
+{
+	if(dev >= devices_qty || devices[dev].streaming)
+	{
+		return;
+	}
+	devices[dev].head = devices[dev].tail;
+	devices[dev].streaming = true;
+	GPIOActivInt(devices[dev].dout, HX711DataReadyIsr, false, &devices[dev]);
+}
+
+void HX711_stopStream(uint8_t dev)
+{
+	if(dev >= devices_qty || !devices[dev].streaming)
+	{
+		return;
+	}
+	GPIODeactivInt(devices[dev].dout);
+	devices[dev].streaming = false;
+}
+
+uint16_t HX711_readSamples(uint8_t dev, hx711_sample_t *samples, uint16_t max_qty, uint32_t timeout_ms)
+{
+	hx711_device_t *device = &devices[dev];
+	uint16_t qty = 0;
+	uint16_t tail;
+	if(dev >= devices_qty)
+	{
+		return 0;
+	}
+	tail = device->tail;
+	if(tail == device->head && timeout_ms > 0)
+	{
+		xSemaphoreTake(device->available, pdMS_TO_TICKS(timeout_ms));
+	}
+	while(qty < max_qty && tail != device->head)
+	{
+		samples[qty++] = device->buffer[tail];
+		tail = (tail + 1) & BUFFER_MASK;
+	}
+	device->tail = tail;
+	return qty;
+}
+
+uint32_t HX711_getOverflows(uint8_t dev)
+{
+	return (dev < devices_qty) ? devices[dev].overflows : 0;
+}
+
+void HX711_filterConfig(uint8_t dev, const hx711_filter_config_t *config)
+{
+	if(dev >= devices_qty)
+	{
+		return;
+	}
+	devices[dev].filter = *config;
+	if(devices[dev].filter.window == 0 || devices[dev].filter.window > HX711_WINDOW_SIZE)
+	{
+		devices[dev].filter.window = HX711_WINDOW_SIZE;
+	}
+	HX711FilterReset(&devices[dev]);
+}
+
+uint16_t HX711_filterUpdate(uint8_t dev, uint32_t timeout_ms)
+{
+	hx711_sample_t samples[8];
+	uint16_t qty, total = 0;
+	if(dev >= devices_qty)
+	{
+		return 0;
+	}
+	while((qty = HX711_readSamples(dev, samples, 8, total ? 0 : timeout_ms)) > 0)
+	{
+		for(uint16_t i = 0; i < qty; i++)
+		{
+			HX711FilterSample(&devices[dev], &samples[i]);
+		}
+		total += qty;
+	}
+	return total;
+}
+
+bool HX711_getWeight(uint8_t dev, hx711_weight_t *weight)
+{
+	if(dev >= devices_qty || devices[dev].window_qty == 0)
+	{
+		return false;
+	}
+	portENTER_CRITICAL(&hx711_mux);
+	*weight = devices[dev].weight;
+	portEXIT_CRITICAL(&hx711_mux);
+	return true;
+}
+
+void HX711_tareDevice(uint8_t dev)
+{
+	if(dev >= devices_qty || devices[dev].window_qty == 0)
+	{
+		return;
+	}
+	devices[dev].offset = (double)devices[dev].sum / devices[dev].window_qty;
+	portENTER_CRITICAL(&hx711_mux);
+	devices[dev].weight.weight = 0;
+	portEXIT_CRITICAL(&hx711_mux);
+}
 
-	GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
+void HX711_setDeviceScale(uint8_t dev, float scale)
+{
+	if(dev < devices_qty)
+	{
+		devices[dev].scale = scale;
+	}
+}
+
+int32_t HX711_readRaw(uint8_t dev)
+{
+	hx711_sample_t sample;
+	hx711_device_t *device = &devices[dev];
+	if(dev >= devices_qty)
+	{
+		return 0;
+	}
+	if(device->streaming)
+	{
+		while(HX711_readSamples(dev, &sample, 1, 1000) == 0);
+		return sample.value;
+	}
+	// wait for the chip to become ready
+	while(GPIORead(device->dout))
+	{
+		vTaskDelay(1);
+	}
+	return HX711ShiftIn(device);
+}
+
+int HX711_isReady(void)
+{
+    return (GPIORead(devices[0].dout)) == 0;
+}
+
+void HX711_setGain(uint8_t gain)
+{
+	HX711SetGain(&devices[0], gain);
 	HX711_read();
 }
 
 uint32_t HX711_read(void)
 {
-	// wait for the chip to become ready
-	while (!HX711_isReady());
-
-    unsigned long count;
-    unsigned char i;
-
-    GPIOOn(internal_dout);//DOUT_SET_HIGH;
-
-    DelayUs(1);
-
-    GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
-    DelayUs(1);
-
-    count=0;
-    while(GPIORead(internal_dout));
-    for(i=0;i<24;i++)
-    {
-    	 GPIOOn(internal_pd_sck);//PD_SCK_SET_HIGH;
-    	 DelayUs(1);
-        count=count<<1;
-        GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
-        DelayUs(1);
-        if(GPIORead(internal_dout))
-            count++;
-    }
-    count = count>>6;
-    GPIOOn(internal_pd_sck);//PD_SCK_SET_HIGH;
-    DelayUs(1);
-    GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
-    DelayUs(1);
-    count ^= 0x800000;
-    return(count);
+	return (uint32_t)(HX711_readRaw(0) & 0xFFFFFF) ^ 0x800000;
 }
 
 uint32_t HX711_readAverage(uint8_t times)
@@ -120,19 +436,18 @@ uint32_t HX711_readAverage(uint8_t times)
 	for (uint8_t i = 0; i < times; i++)
 	{
 		sum += HX711_read();
-		// TODO: See if yield will work | yield();
 	}
 	return sum / times;
 }
 
-double HX711_getValue(uint8_t times)
+double HX711_get_value(uint8_t times)
 {
-	return HX711_readAverage(times) - OFFSET;
+	return HX711_readAverage(times) - devices[0].offset;
 }
 
-float HX711_getUnits(uint8_t times)
+float HX711_get_units(uint8_t times)
 {
-	return HX711_get_value(times) / SCALE;
+	return HX711_get_value(times) / devices[0].scale;
 }
 
 void HX711_tare(uint8_t times)
@@ -143,34 +458,32 @@ void HX711_tare(uint8_t times)
 
 void HX711_setScale(float scale)
 {
-	SCALE = scale;
+	devices[0].scale = scale;
 }
 
 float HX711_getScale(void)
 {
-	return SCALE;
+	return devices[0].scale;
 }
 
 void HX711_setOffset(double offset)
 {
-    OFFSET = offset;
+    devices[0].offset = offset;
 }
 
 double HX711_getOffset(void)
 {
-	return OFFSET;
+	return devices[0].offset;
 }
 
 void HX711_powerDown(void)
 {
-	GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
-	GPIOOn(internal_pd_sck);//PD_SCK_SET_HIGH;
+	GPIOOff(devices[0].pd_sck);//PD_SCK_SET_LOW;
+	GPIOOn(devices[0].pd_sck);//PD_SCK_SET_HIGH;
 	DelayUs(70);
 }
 
 void HX711_powerUp(void)
 {
-	GPIOOff(internal_pd_sck);//PD_SCK_SET_LOW;
+	GPIOOff(devices[0].pd_sck);//PD_SCK_SET_LOW;
 }
-
-
@@ -12,9 +12,12 @@
 /*==================[inclusions]=============================================*/
 #include "ili9341.h"
 #include "fonts.h"
+#include "qoi.h"
 #include "spi_mcu.h"
 #include "gpio_mcu.h"
 #include "delay_mcu.h"
+#include <string.h>
+#include "esp_heap_caps.h"
 /*==================[macros and definitions]=================================*/
 #define NULL 0
 
@@ -23,10 +26,14 @@
 #define MSK_BIT16 0x8000			/*!< 16th bit mask */
 #define MSK_BIT8 0x80				/*!< 8th bit mask */
 #define MAX_VALUE_SIZE 256			/*!< Maximum length of a data array to prevent excessive use of memory */
-#define LEFT -1						/*!< Horizontal grow direction */
-#define RIGHT 1						/*!< Horizontal grow direction */
-#define DOWN 1						/*!< Vertical grow direction */
-#define UP -1						/*!< Vertical grow direction */
+#define DMA_BUFFER_QTY 2			/*!< Number of DMA buffers requested to the SPI buffer pool */
+#define DMA_BUFFER_SIZE ILI9341_WIDTH*2*16	/*!< Size of DMA buffers (16 lines of pixels) */
+#define WINDOW_TRANSFERS 5			/*!< Transfers needed to define an area and start writing it */
+#define FB_DIRTY_QTY 8				/*!< Maximum number of dirty rectangles tracked per band */
+#define FB_MAX_WIDTH 320			/*!< Band width in the widest orientation (landscape) */
+#define GLYPH_CACHE_QTY 32			/*!< Maximum number of colorized glyphs in cache */
+#define GLYPH_CACHE_BYTES 16384		/*!< Memory used by the glyph cache */
+#define GLYPH_MAX_BYTES (GLYPH_CACHE_BYTES / 4)	/*!< Bigger glyphs are not cached (expanded row by row) */
 
 /* Command List */
 #define RESET				0x01 	/*!< Resets the commands and parameters to their S/W Reset default values */
@@ -82,6 +89,80 @@ typedef struct {
     uint32_t databytes; 	/*!< Number of bytes of data to transmit */
     uint8_t *data;			/*!< Pointer to data or parameters array */
 } lcd_cmd_t;
+
+/**
+ * @brief Rectangular area of the LCD (inclusive coordinates)
+ */
+typedef struct {
+	uint16_t x0;			/*!< Start column */
+	uint16_t y0;			/*!< Start row */
+	uint16_t x1;			/*!< End column */
+	uint16_t y1;			/*!< End row */
+} lcd_rect_t;
+
+/**
+ * @brief Band framebuffer state
+ */
+typedef struct {
+	uint8_t *buffer;					/*!< RGB565 band buffer (big endian, as sent to LCD). NULL: direct mode */
+	uint16_t band_lines;				/*!< Number of rows of the buffer */
+	uint16_t band_y;					/*!< First row of the current band */
+	uint16_t band_h;					/*!< Number of rows of the current band */
+	uint16_t background;				/*!< Color used to clear the band before drawing */
+	lcd_rect_t window;					/*!< Area defined by the last SetCursorPosition */
+	uint16_t cursor_x;					/*!< Next column to write inside window */
+	uint16_t cursor_y;					/*!< Next row to write inside window */
+	lcd_rect_t dirty[FB_DIRTY_QTY];		/*!< Areas of the band changed since last flush */
+	uint8_t dirty_qty;					/*!< Number of dirty rectangles */
+} framebuffer_t;
+
+/**
+ * @brief Run-length encoded icon decoder state
+ */
+typedef struct {
+	const uint8_t *code;	/*!< Next byte of encoded data */
+	uint16_t left;			/*!< Pixels left in current literal or run */
+	uint8_t bits;			/*!< Pixels left in literal (next one in bit 7) */
+	bool literal;			/*!< Current code is a literal */
+	bool on;				/*!< Color of current run (true: foreground) */
+	uint16_t foreground;	/*!< Color for icon (RGB565) */
+	uint16_t background;	/*!< Color for icon background (RGB565) */
+} icon_decoder_t;
+
+/**
+ * @brief Colorized glyph (RGB565, high byte first) in the glyph cache
+ */
+typedef struct {
+	Font_t *font;			/*!< Font of the glyph (NULL: free entry) */
+	char character;			/*!< Character */
+	uint16_t foreground;	/*!< Foreground color */
+	uint16_t background;	/*!< Background color */
+	uint32_t size;			/*!< Size of pixels array in bytes */
+	uint32_t last_use;		/*!< Value of glyph_clock when last used (LRU) */
+	uint8_t *pixels;		/*!< Glyph pixels */
+} glyph_t;
+
+/**
+ * @brief Run of characters drawn by DrawText
+ */
+typedef struct {
+	const char *str;		/*!< First character */
+	uint16_t len;			/*!< Number of characters */
+	uint8_t cell;			/*!< Width of every character cell (0: proportional) */
+	Font_t *font;			/*!< Font */
+	uint16_t foreground;	/*!< Color for chars (RGB565) */
+	uint16_t background;	/*!< Color for background (RGB565) */
+} text_run_t;
+
+/**
+ * @brief Renders rows of an image into a strip buffer (RGB565, high byte first)
+ * @param[in]  	param: Image state
+ * @param[out] 	dst: Destination (rows * width * 2 bytes)
+ * @param[in]  	row: First row of the strip
+ * @param[in]  	rows: Number of rows
+ * @param[in]  	width: Pixels per row
+ */
+typedef void (*strip_fill_t)(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width);
 /*==================[internal data declaration]==============================*/
 
 /*==================[internal functions declaration]=========================*/
@@ -94,7 +175,9 @@ typedef struct {
 void WriteLCD(lcd_cmd_t * data);
 
 /**
- * @brief  		Define an area of frame memory where MCU can access
+ * @brief  		Define an area of frame memory where MCU can access and start writing it
+ * @note		Transactions are only queued: the pixel data write that follows
+ * 				waits for all of them
  * @param[in]  	x1: Start column
  * @param[in]  	y1: Start row
  * @param[in]  	x2: End column
@@ -103,6 +186,23 @@ void WriteLCD(lcd_cmd_t * data);
  */
 void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 
+/**
+ * @brief  		Send command and parameters/data to LCD, bypassing the framebuffer
+ * @param[in]  	data: Structure with the command and parameters/data to send
+ * @retval 		None
+ */
+static void SendLCD(lcd_cmd_t * data);
+
+/**
+ * @brief  		Queue the transfers that define an area of LCD memory and start writing it
+ * @param[in]  	x1: Start column
+ * @param[in]  	y1: Start row
+ * @param[in]  	x2: End column
+ * @param[in]  	y2: End row
+ * @retval 		None
+ */
+static void QueueWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
 /**
  * @brief  		Fill an srea of LCD with a determined color
  * @param[in]  	x1: Start column
@@ -114,6 +214,184 @@ void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
  */
 void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
 
+/**
+ * @brief  		Fill an area clipped to the LCD (one window)
+ * @param[in]  	x0: Start column
+ * @param[in]  	y0: Start row
+ * @param[in]  	x1: End column
+ * @param[in]  	y1: End row
+ * @param[in]	color: color
+ * @retval 		None
+ */
+static void Span(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief  		Draw a line as horizontal or vertical runs of pixels (Bresenham)
+ * @note		Each run is a single span, thickness rows (or columns) wide
+ * @param[in]  	x0: X coordinate of starting point
+ * @param[in]  	y0: Y coordinate of starting point
+ * @param[in]  	x1: X coordinate of ending point
+ * @param[in]  	y1: Y coordinate of ending point
+ * @param[in]  	thickness: Line thickness in pixels
+ * @param[in]	color: color
+ * @retval 		None
+ */
+static void LineRuns(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color);
+
+/**
+ * @brief  		Draw the spans of the eight octants of a circle outline for a run of 
+ * 				the midpoint algorithm (points xs..xe at distance y)
+ * @param[in]  	x0: X coordinate of center circle point
+ * @param[in]  	y0: Y coordinate of center circle point
+ * @param[in]  	xs: Start of run
+ * @param[in]  	xe: End of run
+ * @param[in]  	y: Distance of run to center
+ * @param[in]	color: color
+ * @retval 		None
+ */
+static void CircleSpans(int16_t x0, int16_t y0, int16_t xs, int16_t xe, int16_t y, uint16_t color);
+
+/**
+ * @brief  		Add an area to the dirty rectangles of the band
+ * @note		Overlapping or touching areas are merged. When the list is full, the 
+ * 				area is merged with the rectangle that grows the least.
+ * @param[in]  	x0: Start column
+ * @param[in]  	y0: Start row
+ * @param[in]  	x1: End column
+ * @param[in]  	y1: End row
+ * @retval 		None
+ */
+static void FramebufferMarkDirty(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
+/**
+ * @brief  		Fill an area of the band buffer (clipped to the band)
+ * @param[in]  	x0: Start column
+ * @param[in]  	y0: Start row
+ * @param[in]  	x1: End column
+ * @param[in]  	y1: End row
+ * @param[in]	color: color
+ * @retval 		None
+ */
+static void FramebufferFill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
+
+/**
+ * @brief  		Copy pixel data into the band buffer, following the current window
+ * @param[in]  	data: Pixels (2 bytes/pixel, high byte first)
+ * @param[in]  	bytes: Number of bytes
+ * @retval 		None
+ */
+static void FramebufferWrite(uint8_t *data, uint32_t bytes);
+
+/**
+ * @brief  		Start drawing the band at row fb.band_y (buffer cleared to background)
+ * @retval 		None
+ */
+static void FramebufferBand(void);
+
+/**
+ * @brief  		Queue a DMA buffer of pixel data (after a window was defined)
+ * @note		The buffer is returned to the SPI buffer pool when its transfer ends
+ * @param[in]  	buffer: Buffer taken from SPI buffer pool
+ * @param[in]  	size: Number of bytes
+ * @retval 		None
+ */
+static void QueuePixels(uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief  		Get a colorized glyph from the cache, rendering it if needed
+ * @param[in]  	font: Pointer to font
+ * @param[in]  	c: Character
+ * @param[in]  	foreground: Color for char (RGB565)
+ * @param[in]  	background: Color for char background (RGB565)
+ * @retval 		Pointer to glyph pixels, NULL if the glyph is too big to be cached
+ */
+static const uint8_t * GlyphGet(Font_t *font, char c, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Expand a row of a 1-bpp glyph into RGB565 pixels
+ * @param[in]  	font: Pointer to font
+ * @param[in]  	c: Character
+ * @param[in]  	row: Glyph row
+ * @param[in]  	foreground: Color for char (RGB565)
+ * @param[in]  	background: Color for char background (RGB565)
+ * @param[out] 	dst: Destination (2 bytes/pixel)
+ * @retval 		None
+ */
+static void GlyphRow(Font_t *font, char c, uint16_t row, uint16_t foreground, uint16_t background, uint8_t *dst);
+
+/**
+ * @brief  		Send the pixels of the window defined by SetCursorPosition, by strips of rows
+ * @note		Every strip is rendered by fill into a DMA buffer from the SPI buffer pool, 
+ * 				and sent while the next one is rendered. Without DMA buffers (or with the 
+ * 				band framebuffer) strips are one row of line_buffer.
+ * @param[in]  	width: Window width (up to FB_MAX_WIDTH)
+ * @param[in]  	height: Window height
+ * @param[in]  	fill: Function that renders the strips
+ * @param[in]  	param: Parameter of fill
+ * @retval 		None
+ */
+static void DrawStrips(uint16_t width, uint16_t height, strip_fill_t fill, void *param);
+
+/**
+ * @brief  		Render rows of a run of characters (strip_fill_t of DrawText)
+ */
+static void TextFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width);
+
+/**
+ * @brief  		Draw a run of characters in a single window
+ * @note		Rows of the whole run are rendered from cached glyphs (when all the 
+ * 				glyphs fit in the cache) into line buffers, that are sent while the 
+ * 				next ones are rendered.
+ * @param[in]  	x: X position of top left corner
+ * @param[in]  	y: Y position of top left corner
+ * @param[in]  	str: Pointer to first character
+ * @param[in]  	len: Number of characters
+ * @param[in]  	cell: Width of every character cell (0: proportional, 1 pixel between characters)
+ * @param[in]  	font: Pointer to used font
+ * @param[in]  	foreground: Color for chars (RGB565)
+ * @param[in]  	background: Color for background (RGB565)
+ * @retval 		None
+ */
+static void DrawText(uint16_t x, uint16_t y, const char *str, uint16_t len, uint8_t cell, Font_t *font, uint16_t foreground, uint16_t background);
+
+/**
+ * @brief  		Decode pixels of a run-length encoded icon (see icon_font_t)
+ * @param[in]  	dec: Decoder state
+ * @param[out] 	dst: Destination (2 bytes/pixel)
+ * @param[in]  	pixels: Number of pixels to decode
+ * @retval 		None
+ */
+static void IconDecode(icon_decoder_t *dec, uint8_t *dst, uint32_t pixels);
+
+/**
+ * @brief  		Decode rows of an icon (strip_fill_t of ILI9341DrawIcon)
+ */
+static void IconFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width);
+
+/**
+ * @brief  		Copy rows of a picture from flash (strip_fill_t of ILI9341DrawPicture)
+ */
+static void PictureFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width);
+
+/**
+ * @brief  		Decode rows of a QOI image (strip_fill_t of ILI9341DrawQoi)
+ */
+static void QoiFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width);
+
+/**
+ * @brief  		Width of the digit cells of a font (width of its widest digit)
+ * @param[in]  	font: Pointer to font
+ * @retval 		Width in pixels
+ */
+static uint8_t DigitWidth(Font_t *font);
+
+/**
+ * @brief  		Send a dirty rectangle of the band to the LCD
+ * @param[in]  	rect: Area to send
+ * @retval 		None
+ */
+static void FramebufferSendRect(lcd_rect_t *rect);
+
 /*==================[internal data definition]===============================*/
 /**
  * @brief Initial LCD configuration parameters
@@ -183,7 +461,31 @@ spi_mcu_config_t spi_conf = {
 	.param_p = NULL };
 
 static spi_dev_t ili9341_spi;				/*!< uC SPI port */
-static gpio_t ili9341_dc, ili9341_rst;		/*!< uC GPIO ports to use as CS, DC and RST */
+static spi_transfer_t lcd_cmd_transfer = {.size = 1, .dc = SPI_DC_COMMAND};	/*!< Command transfer */
+static spi_transfer_t lcd_data_transfer = {.dc = SPI_DC_DATA};				/*!< Parameters/data transfer */
+static uint8_t window_cmds[] = {COLUMN_ADDR_SET, PAGE_ADDR_SET, MEM_WRITE};	/*!< Commands that define an area */
+static uint8_t window_params[8];			/*!< Start/end column and start/end page */
+static framebuffer_t fb = {.buffer = NULL};	/*!< Band framebuffer (disabled by default) */
+static spi_transfer_t *pixel_transfers = NULL;	/*!< Transfers of DMA pixel buffers (one per pool buffer) */
+static uint8_t pixel_transfer_qty = 0;		/*!< Number of pixel_transfers */
+static bool dma_buffers = false;			/*!< SPI DMA buffer pool is available */
+static uint8_t line_buffer[FB_MAX_WIDTH * 2];	/*!< Pixel line when DMA buffers can't be used */
+static glyph_t glyph_cache[GLYPH_CACHE_QTY];	/*!< Colorized glyphs cache */
+static const uint8_t *run_glyphs[FB_MAX_WIDTH];	/*!< Cached glyph of every character of the text being drawn */
+static uint32_t glyph_cache_bytes = 0;		/*!< Memory used by cached glyphs */
+static uint32_t glyph_clock = 0;			/*!< Glyph uses counter (LRU) */
+static qoi_decoder_t qoi_dec;				/*!< QOI image decoder */
+/**
+ * @brief Pre-built transfers to define an area of frame memory and start writing it
+ */
+static spi_transfer_t lcd_window[WINDOW_TRANSFERS] = {
+	{.tx_buffer = &window_cmds[0], .size = 1, .dc = SPI_DC_COMMAND},
+	{.tx_buffer = &window_params[0], .size = 4, .dc = SPI_DC_DATA},
+	{.tx_buffer = &window_cmds[1], .size = 1, .dc = SPI_DC_COMMAND},
+	{.tx_buffer = &window_params[4], .size = 4, .dc = SPI_DC_DATA},
+	{.tx_buffer = &window_cmds[2], .size = 1, .dc = SPI_DC_COMMAND},
+};
+static gpio_t ili9341_rst;					/*!< uC GPIO port to use as RST */
 
 static orientation_properties_t lcd_orientation = {
 		ILI9341_WIDTH,
@@ -194,19 +496,29 @@ static orientation_properties_t lcd_orientation = {
 /*==================[internal functions definition]==========================*/
 
 void WriteLCD(lcd_cmd_t * data){
-	SpiInit(&spi_conf);
+	/* Framebuffer mode: pixel data goes to the band buffer, commands go to the LCD */
+	if ((fb.buffer != NULL) && (data->cmd == NULL)){
+		FramebufferWrite(data->data, data->databytes);
+		return;
+	}
+	SendLCD(data);
+}
+
+static void SendLCD(lcd_cmd_t * data){
 	/* If command is NULL don't send command */
 	if (data->cmd != NULL){
-		/* Send command */
-		GPIOOff(ili9341_dc);
-		SpiWrite(ili9341_spi, &data->cmd, 1);
+		/* Command byte is sent with DC low (driven by SPI driver) */
+		lcd_cmd_transfer.tx_buffer = &data->cmd;
+		SpiQueueTransfer(ili9341_spi, &lcd_cmd_transfer);
 	}
 	/* If there are parameters or data to send */
 	if (data->databytes != NULL){
-		/* Send parameters or data */
-		GPIOOn(ili9341_dc);
-		SpiWrite(ili9341_spi, data->data, data->databytes);
+		/* Parameters or data are sent with DC high, right after the command */
+		lcd_data_transfer.tx_buffer = data->data;
+		lcd_data_transfer.size = data->databytes;
+		SpiQueueTransfer(ili9341_spi, &lcd_data_transfer);
 	}
+	SpiWaitTransfers(ili9341_spi, portMAX_DELAY);
 }
 
 void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
@@ -223,20 +535,47 @@ void SetCursorPosition(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
 		y0 = y1;
 		y1 = aux;
 	}
-	uint8_t columns[] = {HighByte(x0), LowByte(x0), HighByte(x1), LowByte(x1)};
-	lcd_cmd_t lcd_columns = {COLUMN_ADDR_SET, 4, columns};
-	uint8_t rows[] = {HighByte(y0), LowByte(y0), HighByte(y1), LowByte(y1)};
-	lcd_cmd_t lcd_rows = {PAGE_ADDR_SET, 4, rows};
-	WriteLCD(&lcd_columns);
-	WriteLCD(&lcd_rows);
+	/* Framebuffer mode: the next pixel data is written to the band buffer */
+	if (fb.buffer != NULL){
+		fb.window.x0 = x0;
+		fb.window.y0 = y0;
+		fb.window.x1 = x1;
+		fb.window.y1 = y1;
+		fb.cursor_x = x0;
+		fb.cursor_y = y0;
+		return;
+	}
+	QueueWindow(x0, y0, x1, y1);
+}
+
+static void QueueWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
+	window_params[0] = HighByte(x0);
+	window_params[1] = LowByte(x0);
+	window_params[2] = HighByte(x1);
+	window_params[3] = LowByte(x1);
+	window_params[4] = HighByte(y0);
+	window_params[5] = LowByte(y0);
+	window_params[6] = HighByte(y1);
+	window_params[7] = LowByte(y1);
+	/* Column, page and memory write commands are queued back to back (short 
+	 * transfers are copied into the transactions, so params can be reused) */
+	for (uint8_t i = 0; i < WINDOW_TRANSFERS; i++){
+		SpiQueueTransfer(ili9341_spi, &lcd_window[i]);
+	}
 }
 
 void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
-	static uint16_t i;
+	static uint32_t i;
 	static int32_t bytes_count;
 	static int16_t x_dist, y_dist;
 	static uint8_t pixel[MAX_VALUE_SIZE];
+	uint8_t *buffer;
+	uint32_t buffer_size;
 
+	if (fb.buffer != NULL){
+		FramebufferFill(x0, y0, x1, y1, color);
+		return;
+	}
 	x_dist = x1 - x0;
 	y_dist = y1 - y0;
 	if (x0 > x1){
@@ -250,21 +589,560 @@ void Fill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
 	/* Define area to fill */
 	SetCursorPosition(x0, y0, x1, y1);
 
-	for (i = 0; i < MAX_VALUE_SIZE; i += 2){
-		pixel[i] = HighByte(color);
-		pixel[i + 1] = LowByte(color);
+	/* Use a DMA buffer from the pool if there is one available, so big areas are
+	 * written with few long transfers (short spans use the static buffer) */
+	buffer = (bytes_count > MAX_VALUE_SIZE) ? SpiBufferGet(0) : NULL;
+	buffer_size = SpiBufferSize();
+	if (buffer == NULL){
+		buffer = pixel;
+		buffer_size = MAX_VALUE_SIZE;
+	}
+	if (buffer_size > bytes_count){
+		buffer_size = bytes_count;
+	}
+	for (i = 0; i < buffer_size; i += 2){
+		buffer[i] = HighByte(color);
+		buffer[i + 1] = LowByte(color);
 	}
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
 
-	while(bytes_count - MAX_VALUE_SIZE > 0){
-		lcd_cmd_t lcd_pixel = {NULL, MAX_VALUE_SIZE, pixel};
+	while(bytes_count - (int32_t)buffer_size > 0){
+		lcd_cmd_t lcd_pixel = {NULL, buffer_size, buffer};
 		WriteLCD(&lcd_pixel);
-		bytes_count -= MAX_VALUE_SIZE;
+		bytes_count -= buffer_size;
 	}
-	lcd_cmd_t lcd_pixel = {NULL, bytes_count, pixel};
+	lcd_cmd_t lcd_pixel = {NULL, bytes_count, buffer};
 	WriteLCD(&lcd_pixel);
+	if (buffer != pixel){
+		SpiBufferRelease(buffer);
+	}
+}
+
+static void Span(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	int16_t aux;
+
+	if (x0 > x1){
+		aux = x0;
+		x0 = x1;
+		x1 = aux;
+	}
+	if (y0 > y1){
+		aux = y0;
+		y0 = y1;
+		y1 = aux;
+	}
+	/* Clip to LCD */
+	if (x0 < 0){
+		x0 = 0;
+	}
+	if (y0 < 0){
+		y0 = 0;
+	}
+	if (x1 >= lcd_orientation.width){
+		x1 = lcd_orientation.width - 1;
+	}
+	if (y1 >= lcd_orientation.height){
+		y1 = lcd_orientation.height - 1;
+	}
+	if ((x0 > x1) || (y0 > y1)){
+		return;
+	}
+	Fill(x0, y0, x1, y1, color);
+}
+
+static void LineRuns(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color){
+	int16_t dx, dy, sx, sy, error, run, i;
+	/* Offset of the run from the line, so it is centered */
+	int16_t t0 = -(thickness - 1) / 2;
+	int16_t t1 = t0 + thickness - 1;
+
+	dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+	dy = (y1 > y0) ? y1 - y0 : y0 - y1;
+	sx = (x1 >= x0) ? 1 : -1;
+	sy = (y1 >= y0) ? 1 : -1;
+
+	if (dx >= dy){
+		/* Mostly horizontal: one horizontal run for every row */
+		error = dx / 2;
+		run = x0;
+		for (i = 0; i < dx; i++){
+			error -= dy;
+			if (error < 0){
+				Span(run, y0 + t0, x0, y0 + t1, color);
+				y0 += sy;
+				error += dx;
+				run = x0 + sx;
+			}
+			x0 += sx;
+		}
+		Span(run, y0 + t0, x0, y0 + t1, color);
+	}
+	else{
+		/* Mostly vertical: one vertical run for every column */
+		error = dy / 2;
+		run = y0;
+		for (i = 0; i < dy; i++){
+			error -= dx;
+			if (error < 0){
+				Span(x0 + t0, run, x0 + t1, y0, color);
+				x0 += sx;
+				error += dy;
+				run = y0 + sy;
+			}
+			y0 += sy;
+		}
+		Span(x0 + t0, run, x0 + t1, y0, color);
+	}
+}
+
+static void CircleSpans(int16_t x0, int16_t y0, int16_t xs, int16_t xe, int16_t y, uint16_t color){
+	/* Top and bottom octants: horizontal runs */
+	Span(x0 + xs, y0 + y, x0 + xe, y0 + y, color);
+	Span(x0 - xe, y0 + y, x0 - xs, y0 + y, color);
+	Span(x0 + xs, y0 - y, x0 + xe, y0 - y, color);
+	Span(x0 - xe, y0 - y, x0 - xs, y0 - y, color);
+	/* Left and right octants: vertical runs */
+	Span(x0 + y, y0 + xs, x0 + y, y0 + xe, color);
+	Span(x0 + y, y0 - xe, x0 + y, y0 - xs, color);
+	Span(x0 - y, y0 + xs, x0 - y, y0 + xe, color);
+	Span(x0 - y, y0 - xe, x0 - y, y0 - xs, color);
+}
+
+static void FramebufferMarkDirty(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1){
+	lcd_rect_t *rect;
+	uint32_t growth, best_growth = UINT32_MAX;
+	uint8_t i, best = 0;
+
+	for (i = 0; i < fb.dirty_qty; i++){
+		rect = &fb.dirty[i];
+		/* Overlapping or touching: grow it */
+		if ((x0 <= rect->x1 + 1) && (rect->x0 <= x1 + 1) && (y0 <= rect->y1 + 1) && (rect->y0 <= y1 + 1)){
+			best = i;
+			best_growth = 0;
+			break;
+		}
+	}
+	if ((best_growth != 0) && (fb.dirty_qty < FB_DIRTY_QTY)){
+		fb.dirty[fb.dirty_qty++] = (lcd_rect_t){x0, y0, x1, y1};
+		return;
+	}
+	if (best_growth != 0){
+		/* List full: merge with the rectangle whose area grows the least */
+		for (i = 0; i < fb.dirty_qty; i++){
+			rect = &fb.dirty[i];
+			growth = (uint32_t)((x1 > rect->x1 ? x1 : rect->x1) - (x0 < rect->x0 ? x0 : rect->x0) + 1) *
+					((y1 > rect->y1 ? y1 : rect->y1) - (y0 < rect->y0 ? y0 : rect->y0) + 1) -
+					(uint32_t)(rect->x1 - rect->x0 + 1) * (rect->y1 - rect->y0 + 1);
+			if (growth < best_growth){
+				best_growth = growth;
+				best = i;
+			}
+		}
+	}
+	rect = &fb.dirty[best];
+	rect->x0 = (x0 < rect->x0) ? x0 : rect->x0;
+	rect->y0 = (y0 < rect->y0) ? y0 : rect->y0;
+	rect->x1 = (x1 > rect->x1) ? x1 : rect->x1;
+	rect->y1 = (y1 > rect->y1) ? y1 : rect->y1;
+}
+
+static void FramebufferFill(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
+	uint16_t *row;
+	uint16_t aux, x, y;
+	/* Pixels are stored high byte first */
+	uint16_t pixel = (color >> 8) | (color << 8);
+
+	if (x0 > x1){
+		aux = x0;
+		x0 = x1;
+		x1 = aux;
+	}
+	if (y0 > y1){
+		aux = y0;
+		y0 = y1;
+		y1 = aux;
+	}
+	/* Clip to band */
+	if (x1 >= lcd_orientation.width){
+		x1 = lcd_orientation.width - 1;
+	}
+	if (y0 < fb.band_y){
+		y0 = fb.band_y;
+	}
+	if (y1 >= fb.band_y + fb.band_h){
+		y1 = fb.band_y + fb.band_h - 1;
+	}
+	if ((x0 > x1) || (y0 > y1)){
+		return;
+	}
+	for (y = y0; y <= y1; y++){
+		row = (uint16_t *)fb.buffer + (y - fb.band_y) * lcd_orientation.width;
+		for (x = x0; x <= x1; x++){
+			row[x] = pixel;
+		}
+	}
+	FramebufferMarkDirty(x0, y0, x1, y1);
+}
+
+static void FramebufferWrite(uint8_t *data, uint32_t bytes){
+	uint32_t pixels = bytes / 2;
+	uint32_t n, copy;
+	int32_t first_row = fb.cursor_y;
+	int32_t last_row;
+	uint16_t x1;
+
+	while ((pixels > 0) && (fb.cursor_y <= fb.window.y1)){
+		/* Pixels left in current window row */
+		n = fb.window.x1 - fb.cursor_x + 1;
+		if (n > pixels){
+			n = pixels;
+		}
+		/* Only rows of the current band are stored */
+		if ((fb.cursor_y >= fb.band_y) && (fb.cursor_y < fb.band_y + fb.band_h) && (fb.cursor_x < lcd_orientation.width)){
+			copy = n;
+			if (fb.cursor_x + copy > lcd_orientation.width){
+				copy = lcd_orientation.width - fb.cursor_x;
+			}
+			memcpy(fb.buffer + ((fb.cursor_y - fb.band_y) * lcd_orientation.width + fb.cursor_x) * 2, data, copy * 2);
+		}
+		data += n * 2;
+		pixels -= n;
+		fb.cursor_x += n;
+		if (fb.cursor_x > fb.window.x1){
+			fb.cursor_x = fb.window.x0;
+			fb.cursor_y++;
+		}
+	}
+	/* Rows touched by this write, clipped to band */
+	last_row = (fb.cursor_x == fb.window.x0) ? fb.cursor_y - 1 : fb.cursor_y;
+	if (first_row < fb.band_y){
+		first_row = fb.band_y;
+	}
+	if (last_row >= fb.band_y + fb.band_h){
+		last_row = fb.band_y + fb.band_h - 1;
+	}
+	x1 = (fb.window.x1 < lcd_orientation.width) ? fb.window.x1 : lcd_orientation.width - 1;
+	if ((first_row <= last_row) && (fb.window.x0 <= x1)){
+		FramebufferMarkDirty(fb.window.x0, first_row, x1, last_row);
+	}
+}
+
+static void FramebufferBand(void){
+	uint16_t *pixels = (uint16_t *)fb.buffer;
+	uint16_t pixel = (fb.background >> 8) | (fb.background << 8);
+	uint32_t i, qty;
+
+	fb.band_h = lcd_orientation.height - fb.band_y;
+	if (fb.band_h > fb.band_lines){
+		fb.band_h = fb.band_lines;
+	}
+	qty = (uint32_t)fb.band_h * lcd_orientation.width;
+	for (i = 0; i < qty; i++){
+		pixels[i] = pixel;
+	}
+	fb.dirty_qty = 0;
+}
+
+static void FramebufferSendRect(lcd_rect_t *rect){
+	uint32_t stride = lcd_orientation.width * 2;
+	uint32_t row_bytes = (rect->x1 - rect->x0 + 1) * 2;
+	uint32_t rows = rect->y1 - rect->y0 + 1;
+	uint32_t chunk_rows, i;
+	uint8_t *src = fb.buffer + (rect->y0 - fb.band_y) * stride + rect->x0 * 2;
+	uint8_t *buffer;
+
+	QueueWindow(rect->x0, rect->y0, rect->x1, rect->y1);
+	/* Full width rows are contiguous in the band: a single transfer */
+	if (row_bytes == stride){
+		lcd_cmd_t lcd_pixels = {NULL, rows * row_bytes, src};
+		SendLCD(&lcd_pixels);
+		return;
+	}
+	/* Rows are packed into DMA buffers, each one is released when its transfer 
+	 * ends, so packing the next chunk overlaps with the previous transfer */
+	while (rows > 0){
+		buffer = NULL;
+		if (dma_buffers && (row_bytes <= SpiBufferSize())){
+			buffer = SpiBufferGet(portMAX_DELAY);
+		}
+		if (buffer == NULL){
+			/* No DMA buffers: one transfer per row */
+			lcd_cmd_t lcd_pixels = {NULL, row_bytes, src};
+			SendLCD(&lcd_pixels);
+			src += stride;
+			rows--;
+			continue;
+		}
+		chunk_rows = SpiBufferSize() / row_bytes;
+		if (chunk_rows > rows){
+			chunk_rows = rows;
+		}
+		for (i = 0; i < chunk_rows; i++){
+			memcpy(buffer + i * row_bytes, src, row_bytes);
+			src += stride;
+		}
+		rows -= chunk_rows;
+		QueuePixels(buffer, chunk_rows * row_bytes);
+	}
+	SpiWaitTransfers(ili9341_spi, portMAX_DELAY);
+}
+
+static void QueuePixels(uint8_t *buffer, uint32_t size){
+	spi_transfer_t *transfer = NULL;
+	uint8_t i;
+
+	/* Every pool buffer keeps its own transfer: a buffer is only available again 
+	 * when its transfer ended, so the transfer is free too */
+	for (i = 0; (i < pixel_transfer_qty) && (transfer == NULL); i++){
+		if (pixel_transfers[i].param_p == buffer){
+			transfer = &pixel_transfers[i];
+		}
+	}
+	for (i = 0; (i < pixel_transfer_qty) && (transfer == NULL); i++){
+		if (pixel_transfers[i].param_p == NULL){
+			transfer = &pixel_transfers[i];
+		}
+	}
+	if (transfer == NULL){
+		/* Buffer not from the pool: sent synchronously */
+		lcd_cmd_t lcd_pixels = {NULL, size, buffer};
+		SendLCD(&lcd_pixels);
+		SpiBufferRelease(buffer);
+		return;
+	}
+	memset(transfer, 0, sizeof(spi_transfer_t));
+	transfer->tx_buffer = buffer;
+	transfer->size = size;
+	transfer->dc = SPI_DC_DATA;
+	transfer->func_p = SpiBufferRelease;
+	transfer->param_p = buffer;
+	if (!SpiQueueTransfer(ili9341_spi, transfer)){
+		SpiBufferRelease(buffer);
+	}
+}
+
+static const uint8_t * GlyphGet(Font_t *font, char c, uint16_t foreground, uint16_t background){
+	glyph_t *glyph, *oldest;
+	uint32_t size = font->info[c - ' '].width * font->font_height * 2;
+	uint16_t row;
+	uint8_t i;
+
+	if (size > GLYPH_MAX_BYTES){
+		return NULL;
+	}
+	glyph_clock++;
+	for (i = 0; i < GLYPH_CACHE_QTY; i++){
+		glyph = &glyph_cache[i];
+		if ((glyph->font == font) && (glyph->character == c) &&
+			(glyph->foreground == foreground) && (glyph->background == background)){
+			glyph->last_use = glyph_clock;
+			return glyph->pixels;
+		}
+	}
+	/* Miss: free least recently used glyphs until there is an entry and memory for it */
+	while (1){
+		glyph = NULL;
+		oldest = NULL;
+		for (i = 0; i < GLYPH_CACHE_QTY; i++){
+			if (glyph_cache[i].font == NULL){
+				glyph = &glyph_cache[i];
+			}
+			else if ((oldest == NULL) || (glyph_cache[i].last_use < oldest->last_use)){
+				oldest = &glyph_cache[i];
+			}
+		}
+		if ((glyph != NULL) && (glyph_cache_bytes + size <= GLYPH_CACHE_BYTES)){
+			break;
+		}
+		heap_caps_free(oldest->pixels);
+		glyph_cache_bytes -= oldest->size;
+		oldest->font = NULL;
+	}
+	glyph->pixels = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+	if (glyph->pixels == NULL){
+		return NULL;
+	}
+	for (row = 0; row < font->font_height; row++){
+		GlyphRow(font, c, row, foreground, background, glyph->pixels + row * font->info[c - ' '].width * 2);
+	}
+	glyph->font = font;
+	glyph->character = c;
+	glyph->foreground = foreground;
+	glyph->background = background;
+	glyph->size = size;
+	glyph->last_use = glyph_clock;
+	glyph_cache_bytes += size;
+	return glyph->pixels;
+}
+
+static void GlyphRow(Font_t *font, char c, uint16_t row, uint16_t foreground, uint16_t background, uint8_t *dst){
+	char_info_t *info = &font->info[c - ' '];
+	const uint8_t *bits = &font->data[info->offset + row * ((info->width + 7) / 8)];
+	uint16_t color;
+
+	for (uint16_t j = 0; j < info->width; j++){
+		color = (bits[j / 8] & (MSK_BIT8 >> (j % 8))) ? foreground : background;
+		*dst++ = HighByte(color);
+		*dst++ = LowByte(color);
+	}
+}
+
+static void DrawStrips(uint16_t width, uint16_t height, strip_fill_t fill, void *param){
+	uint8_t *buffer;
+	uint32_t buffer_size, row_bytes = width * 2;
+	uint16_t row, strip_rows;
+	bool pooled = dma_buffers && (fb.buffer == NULL) && (SpiBufferSize() >= row_bytes);
+
+	if ((width == 0) || (width > FB_MAX_WIDTH)){
+		return;
+	}
+	for (row = 0; row < height; row += strip_rows){
+		buffer = pooled ? SpiBufferGet(portMAX_DELAY) : NULL;
+		if (buffer != NULL){
+			buffer_size = SpiBufferSize();
+		}
+		else{
+			buffer = line_buffer;
+			buffer_size = sizeof(line_buffer);
+		}
+		strip_rows = buffer_size / row_bytes;
+		if (strip_rows > height - row){
+			strip_rows = height - row;
+		}
+		fill(param, buffer, row, strip_rows, width);
+		if (buffer != line_buffer){
+			QueuePixels(buffer, strip_rows * row_bytes);
+		}
+		else{
+			lcd_cmd_t lcd_pixels = {NULL, strip_rows * row_bytes, buffer};
+			WriteLCD(&lcd_pixels);
+		}
+	}
+	SpiWaitTransfers(ili9341_spi, portMAX_DELAY);
+}
+
+static void TextFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width){
+	text_run_t *text = param;
+	Font_t *font = text->font;
+	uint16_t r, i, j, gap, glyph_width;
+
+	for (r = row; r < row + rows; r++){
+		for (i = 0; i < text->len; i++){
+			glyph_width = font->info[text->str[i] - ' '].width;
+			if (text->cell != 0){
+				gap = (text->cell > glyph_width) ? text->cell - glyph_width : 0;
+				if (glyph_width > text->cell){
+					glyph_width = text->cell;
+				}
+			}
+			else{
+				gap = (i < text->len - 1) ? 1 : 0;
+			}
+			if (run_glyphs[i] != NULL){
+				memcpy(dst, run_glyphs[i] + r * font->info[text->str[i] - ' '].width * 2, glyph_width * 2);
+			}
+			else{
+				GlyphRow(font, text->str[i], r, text->foreground, text->background, dst);
+			}
+			dst += glyph_width * 2;
+			for (j = 0; j < gap; j++){
+				*dst++ = HighByte(text->background);
+				*dst++ = LowByte(text->background);
+			}
+		}
+	}
+}
+
+static void DrawText(uint16_t x, uint16_t y, const char *str, uint16_t len, uint8_t cell, Font_t *font, uint16_t foreground, uint16_t background){
+	text_run_t text = {str, len, cell, font, foreground, background};
+	uint32_t glyph_bytes = 0, size;
+	uint16_t width = 0, i, j, distinct = 0;
+	bool cached = (len <= FB_MAX_WIDTH);
+
+	for (i = 0; i < len; i++){
+		width += (cell != 0) ? cell : font->info[str[i] - ' '].width + ((i > 0) ? 1 : 0);
+		/* Memory needed to cache every different glyph of the text */
+		for (j = 0; (j < i) && (str[j] != str[i]); j++);
+		if (j == i){
+			size = font->info[str[i] - ' '].width * font->font_height * 2;
+			glyph_bytes += size;
+			distinct++;
+			if (size > GLYPH_MAX_BYTES){
+				cached = false;
+			}
+		}
+	}
+	if ((width == 0) || (width > FB_MAX_WIDTH)){
+		return;
+	}
+	/* Glyphs are looked up once. If they don't fit in the cache together, they would 
+	 * evict each other: all the rows are expanded from the font instead */
+	cached = cached && (distinct <= GLYPH_CACHE_QTY) && (glyph_bytes <= GLYPH_CACHE_BYTES);
+	for (i = 0; i < len; i++){
+		run_glyphs[i] = cached ? GlyphGet(font, str[i], foreground, background) : NULL;
+	}
+	SetCursorPosition(x, y, x + width - 1, y + font->font_height - 1);
+	/* DMA buffers hold several rows and are sent while the next ones are rendered */
+	DrawStrips(width, font->font_height, TextFill, &text);
+}
+
+static void IconDecode(icon_decoder_t *dec, uint8_t *dst, uint32_t pixels){
+	uint8_t code;
+	uint16_t color;
+	uint32_t n;
+
+	while (pixels > 0){
+		if (dec->left == 0){
+			code = *dec->code++;
+			dec->literal = !(code & MSK_BIT8);
+			if (dec->literal){
+				dec->bits = code << 1;
+				dec->left = 7;
+			}
+			else{
+				dec->on = code & 0x40;
+				n = code & 0x3F;
+				dec->left = (n < 63) ? n + 8 : 71 + *dec->code++;
+			}
+		}
+		if (dec->literal){
+			color = (dec->bits & MSK_BIT8) ? dec->foreground : dec->background;
+			dec->bits <<= 1;
+			n = 1;
+		}
+		else{
+			color = dec->on ? dec->foreground : dec->background;
+			n = (dec->left < pixels) ? dec->left : pixels;
+		}
+		dec->left -= n;
+		pixels -= n;
+		while (n--){
+			*dst++ = HighByte(color);
+			*dst++ = LowByte(color);
+		}
+	}
+}
+
+static void IconFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width){
+	IconDecode(param, dst, (uint32_t)rows * width);
+}
+
+static void PictureFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width){
+	const uint8_t *pic = param;
+	memcpy(dst, pic + (uint32_t)row * width * 2, (uint32_t)rows * width * 2);
+}
+
+static void QoiFill(void *param, uint8_t *dst, uint16_t row, uint16_t rows, uint16_t width){
+	QoiDecode(param, dst, (uint32_t)rows * width);
+}
+
+static uint8_t DigitWidth(Font_t *font){
+	uint8_t width = 0;
+	for (char c = '0'; c <= '9'; c++){
+		if (font->info[c - ' '].width > width){
+			width = font->info[c - ' '].width;
+		}
+	}
+	return width;
 }
 
 /*==================[external functions definition]==========================*/
@@ -273,11 +1151,23 @@ uint8_t ILI9341Init(spi_dev_t spi_dev, uint8_t gpio_dc, uint8_t gpio_rst){
 	/* SPI configuration */
 	spi_conf.device = spi_dev;
 	ili9341_spi = spi_dev;
+	/* SPI bus and device are configured only once, DC pin is driven by the SPI driver */
+	SpiInit(&spi_conf);
+	SpiSetDcPin(ili9341_spi, gpio_dc);
 	/* GPIOs configuration and initialization */
-	ili9341_dc = gpio_dc;
 	ili9341_rst = gpio_rst;
-	GPIOInit(ili9341_dc, GPIO_OUTPUT);
 	GPIOInit(ili9341_rst, GPIO_OUTPUT);
+	/* DMA buffers for big writes (if there is no memory, small static buffers are used) */
+	dma_buffers = SpiBufferPoolInit(DMA_BUFFER_QTY, DMA_BUFFER_SIZE);
+	if (dma_buffers && (pixel_transfers == NULL)){
+		/* The pool may already exist with a different number of buffers */
+		pixel_transfer_qty = SpiBufferQty();
+		pixel_transfers = heap_caps_calloc(pixel_transfer_qty, sizeof(spi_transfer_t), MALLOC_CAP_8BIT);
+		if (pixel_transfers == NULL){
+			pixel_transfer_qty = 0;
+		}
+	}
+	dma_buffers = dma_buffers && (pixel_transfers != NULL);
 
 	/* RST must be held low for minimum 10µsec after VCC have been applied */
 	DelayUs(10);
@@ -303,10 +1193,14 @@ uint8_t ILI9341Init(spi_dev_t spi_dev, uint8_t gpio_dc, uint8_t gpio_rst){
 }
 
 void ILI9341DrawPixel(uint16_t x, uint16_t y, uint16_t color){
+	if (fb.buffer != NULL){
+		FramebufferFill(x, y, x, y, color);
+		return;
+	}
 	/* Define area (pixel) to fill */
 	SetCursorPosition(x, y, x, y);
 	uint8_t pixels[] = {HighByte(color), LowByte(color)};
-	lcd_cmd_t lcd_pixels = {MEM_WRITE, sizeof(pixels), pixels};
+	lcd_cmd_t lcd_pixels = {NULL, sizeof(pixels), pixels};
 	WriteLCD(&lcd_pixels);
 }
 
@@ -347,14 +1241,15 @@ void ILI9341Rotate(ili9341_orientation_t orientation){
 	}
 	lcd_cmd_t lcd_mem_acc = {MEM_ACC_CTRL, 1, mem_acc};
 	WriteLCD(&lcd_mem_acc);
+	/* Band geometry depends on orientation: start again from first band */
+	if (fb.buffer != NULL){
+		fb.band_y = 0;
+		FramebufferBand();
+	}
 }
 
 void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t foreground, uint16_t background){
-	static uint32_t i, j, k;
-	static uint32_t char_row;
 	static uint16_t lcd_x, lcd_y;
-	static int32_t bytes_count, bytes_row;
-	static uint8_t pixel[MAX_VALUE_SIZE];
 
 	/* Set coordinates */
 	lcd_x = x;
@@ -365,58 +1260,13 @@ void ILI9341DrawChar(uint16_t x, uint16_t y, char data, Font_t* font, uint16_t f
 		lcd_y += font->font_height;
 		lcd_x = 0;
 	}
-
-	SetCursorPosition(lcd_x, lcd_y, lcd_x + font->info[data - ' '].width - 1, lcd_y + font->font_height - 1);
-
-	/* Number of bytes to write. We have to write 2 bytes/pixel */
-	bytes_count = font->font_height * font->info[data - ' '].width * 2;
-
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
-
-	/* Draw font data */
-	/* go through character rows */
-	k = 0;
-	for (i = 0; i < font->font_height; i++)	{
-		/* */
-		char_row = font->info[data - ' '].offset + i * ((font->info[data - ' '].width + 7) / 8);
-		/* go through character columns */
-		bytes_row = -1;
-		for (j = 0; j < font->info[data - ' '].width; j++){
-			if(j % 8 == 0){
-				bytes_row++;
-			}
-			/* If exceed buffer size, send buffer */
-			if ((2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1) > MAX_VALUE_SIZE){
-				lcd_cmd_t lcd_pixels = {NULL, MAX_VALUE_SIZE, pixel};
-				WriteLCD(&lcd_pixels);
-				bytes_count -= MAX_VALUE_SIZE;
-				k++;
-			}
-			/* The n=FontWidth first bits of the 16bits row data draws the corresponding part of a character */
-			if (font->data[char_row + bytes_row] & (MSK_BIT8 >> (j % 8))){
-				/* if bit = 1, draw put foreground color */
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE] = HighByte(foreground);
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(foreground);
-			}
-			else{
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE] = HighByte(background);
-				pixel[2 * j + i * font->info[data - ' '].width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(background);
-			}
-		}
-	}
-	/* Send the rest of the buffer */
-	lcd_cmd_t lcd_pixels = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixels);
+	DrawText(lcd_x, lcd_y, &data, 1, 0, font, foreground, background);
 }
 
 void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font, uint16_t foreground, uint16_t background){
-	static uint32_t i, j, k;
-	static uint32_t char_row;
 	static uint16_t lcd_x, lcd_y;
-	static int32_t bytes_count, bytes_row;
-	static uint8_t pixel[MAX_VALUE_SIZE];
+	icon_decoder_t dec = {.code = &icon_font->data[icon_font->index[icon]], .left = 0,
+		.foreground = foreground, .background = background};
 
 	/* Set coordinates */
 	lcd_x = x;
@@ -430,66 +1280,67 @@ void ILI9341DrawIcon(uint16_t x, uint16_t y, icon_t icon, icon_font_t* icon_font
 
 	SetCursorPosition(lcd_x, lcd_y, lcd_x + icon_font->width - 1, lcd_y + icon_font->height - 1);
 
-	/* Number of bytes to write. We have to write 2 bytes/pixel */
-	bytes_count = icon_font->height * icon_font->width * 2;
-
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
-
-	/* Draw font data */
-	/* go through character rows */
-	k = 0;
-	for (i = 0; i < icon_font->height; i++)	{
-		/*  */
-		char_row = icon * icon_font->offset + i * ((icon_font->width + 7) / 8);
-		/* go through character columns */
-		bytes_row = -1;
-		for (j = 0; j < icon_font->width; j++){
-			if(j % 8 == 0){
-				bytes_row++;
-			}
-			/* If exceed buffer size, send buffer */
-			if ((2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1) > MAX_VALUE_SIZE){
-				lcd_cmd_t lcd_pixels = {NULL, MAX_VALUE_SIZE, pixel};
-				WriteLCD(&lcd_pixels);
-				bytes_count -= MAX_VALUE_SIZE;
-				k++;
-			}
-			/* The n=FontWidth first bits of the 16bits row data draws the corresponding part of a character */
-			if (icon_font->data[char_row + bytes_row] & (MSK_BIT8 >> (j % 8))){
-				/* if bit = 1, draw put foreground color */
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE] = HighByte(foreground);
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(foreground);
-			}
-			else{
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE] = HighByte(background);
-				pixel[2 * j + i * icon_font->width * 2 - k * MAX_VALUE_SIZE + 1] = LowByte(background);
-			}
-		}
-	}
-	/* Send the rest of the buffer */
-	lcd_cmd_t lcd_pixels = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixels);
+	/* Icon is decoded straight into line buffers, sent while the next rows are decoded */
+	DrawStrips(icon_font->width, icon_font->height, IconFill, &dec);
 }
 
 void ILI9341DrawInt(uint16_t x, uint16_t y, uint32_t num, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background){
-	static uint16_t i;
-	static uint16_t lcd_x, lcd_y;
+	char digits[ILI9341_FIELD_MAX_DIGITS];
 
-	/* Set coordinates */
-	lcd_x = x;
-	lcd_y = y;
+	if (dig > ILI9341_FIELD_MAX_DIGITS){
+		dig = ILI9341_FIELD_MAX_DIGITS;
+	}
+	for (int8_t i = dig - 1; i >= 0; i--){
+		digits[i] = num % 10 + '0';
+		num = num / 10;
+	}
+	/* All the digits in a single window, one cell per digit */
+	DrawText(x + 1, y, digits, dig, DigitWidth(font), font, foreground, background);
+}
 
-	for (i=0; i<dig; i++){
-		lcd_x = x + font->info[num%10 + '0' - ' '].width * (dig-1-i) + 1;
-		ILI9341DrawChar(lcd_x, lcd_y, num%10 + '0', font, foreground, background);
-		num = num/10;
+void ILI9341NumFieldInit(ili9341_num_field_t *field, uint16_t x, uint16_t y, uint8_t dig, Font_t* font, uint16_t foreground, uint16_t background){
+	field->x = x;
+	field->y = y;
+	field->digits = (dig > ILI9341_FIELD_MAX_DIGITS) ? ILI9341_FIELD_MAX_DIGITS : dig;
+	field->font = font;
+	field->foreground = foreground;
+	field->background = background;
+	field->cell = DigitWidth(font);
+	/* Nothing on screen yet: first update draws every digit */
+	memset(field->text, 0, sizeof(field->text));
+}
+
+void ILI9341NumFieldUpdate(ili9341_num_field_t *field, uint32_t num){
+	char digits[ILI9341_FIELD_MAX_DIGITS];
+	int8_t first = -1, last = -1;
+
+	for (int8_t i = field->digits - 1; i >= 0; i--){
+		digits[i] = num % 10 + '0';
+		num = num / 10;
+		if (digits[i] != field->text[i]){
+			if (last < 0){
+				last = i;
+			}
+			first = i;
+		}
+	}
+	/* The band framebuffer is redrawn from scratch on every pass: draw the whole field */
+	if (fb.buffer != NULL){
+		first = 0;
+		last = field->digits - 1;
+	}
+	/* Only the digits that changed (and the ones between them) are sent */
+	if (first < 0){
+		return;
 	}
+	DrawText(field->x + 1 + first * field->cell, field->y, &digits[first], last - first + 1,
+			field->cell, field->font, field->foreground, field->background);
+	memcpy(&field->text[first], &digits[first], last - first + 1);
 }
 
 void ILI9341DrawString(uint16_t x, uint16_t y, char* str, Font_t *font, uint16_t foreground, uint16_t background){
 	static uint16_t lcd_x, lcd_y;
+	uint16_t len, width, char_width;
 
 	/* Set coordinates */
 	lcd_x = x;
@@ -508,16 +1359,36 @@ void ILI9341DrawString(uint16_t x, uint16_t y, char* str, Font_t *font, uint16_t
 				lcd_x = x;
 			}
 			str++;
+			continue;
 		}
-		else if (*str == '\r'){
+		if (*str == '\r'){
+			str++;
+			continue;
+		}
+		/* Longest run of characters of this line that fits in the display */
+		len = 0;
+		width = 0;
+		while ((str[len] != '\0') && (str[len] != '\n') && (str[len] != '\r')){
+			char_width = font->info[str[len] - ' '].width + ((len > 0) ? 1 : 0);
+			if (lcd_x + width + char_width > lcd_orientation.width){
+				break;
+			}
+			width += char_width;
+			len++;
+		}
+		if (len == 0){
+			/* Character doesn't fit: go to new line and set x to 0 position */
+			if (lcd_x == 0){
 				str++;
 			}
-
-		/* Put character to LCD */
-		ILI9341DrawChar(lcd_x, lcd_y, *str, font, foreground, background);
-		lcd_x += font->info[*str - ' '].width + 1;
-		/* Next character */
-		str++;
+			lcd_y += font->font_height;
+			lcd_x = 0;
+			continue;
+		}
+		/* Whole run in a single window */
+		DrawText(lcd_x, lcd_y, str, len, 0, font, foreground, background);
+		lcd_x += width + 1;
+		str += len;
 	}
 }
 
@@ -535,8 +1406,6 @@ void ILI9341GetStringSize(char* str, Font_t* font, uint16_t* width, uint16_t* he
 }
 
 void ILI9341DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
-	static int16_t x_dist, y_dist, x_grow, y_grow, error, error_2;
-
 	/* Check for overflow */
 	if (x0 >= lcd_orientation.width){
 		x0 = lcd_orientation.width - 1;
@@ -550,60 +1419,33 @@ void ILI9341DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_
 	if (y1 >= lcd_orientation.height){
 		y1 = lcd_orientation.height - 1;
 	}
+	LineRuns(x0, y0, x1, y1, 1, color);
+}
 
-	/* Calculate x y distances and determine grow direction */
-	x_dist = x1 - x0;
-	y_dist = y1 - y0;
-	if (x0 > x1){
-		x_dist = -x_dist;
-		x_grow = LEFT;
-	}
-	else{
-		x_grow = RIGHT;
-	}
-	if (y0 > y1){
-		y_dist = -y_dist;
-		y_grow = UP;
-	}
-	else{
-		y_grow = DOWN;
+void ILI9341DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color){
+	if (thickness == 0){
+		return;
 	}
+	LineRuns(x0, y0, x1, y1, thickness, color);
+}
 
-	/* Vertical or horizontal line */
-	if (x_dist == 0 || y_dist == 0){
-		Fill(x0, y0, x1, y1, color);
+void ILI9341DrawPolyline(const ili9341_point_t *points, uint16_t qty, uint8_t thickness, uint16_t color){
+	if (thickness == 0){
+		return;
 	}
-	/* Diagonal line */
-	else{
-		error = x_dist - y_dist;
-
-		while (1){
-			/* Draw start point */
-			ILI9341DrawPixel(x0, y0, color);
-			/* Loop ends when start point reaches end point */
-			if (x0 == x1 && y0 == y1){
-				break;
-			}
-			error_2 = 2 * error;
-			/* Determine if line must grow in x direction */
-			if (error_2 > -y_dist){
-				error -= y_dist;
-				x0 += x_grow;	/* Move start point */
-			}
-			/* Determine if line must grow in y direction */
-			if (error_2 < x_dist){
-				error += x_dist;
-				y0 += y_grow;	/* Move start point */
-			}
-		}
+	if (qty == 1){
+		LineRuns(points[0].x, points[0].y, points[0].x, points[0].y, thickness, color);
+	}
+	for (uint16_t i = 1; i < qty; i++){
+		LineRuns(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, thickness, color);
 	}
 }
 
 void ILI9341DrawRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
-	ILI9341DrawLine(x0, y0, x1, y0, color);		/* Draw top line */
-	ILI9341DrawLine(x1, y0, x1, y1, color);		/* Draw right line */
-	ILI9341DrawLine(x0, y1, x1, y1, color);		/* Draw bottom line */
-	ILI9341DrawLine(x0, y0, x0, y1, color);		/* Draw left line */
+	Span(x0, y0, x1, y0, color);		/* Draw top line */
+	Span(x1, y0, x1, y1, color);		/* Draw right line */
+	Span(x0, y1, x1, y1, color);		/* Draw bottom line */
+	Span(x0, y0, x0, y1, color);		/* Draw left line */
 }
 
 void ILI9341DrawFilledRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color){
@@ -611,39 +1453,29 @@ void ILI9341DrawFilledRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t
 }
 
 void ILI9341DrawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
-	static int16_t f, ddF_x, ddF_y, x, y;
+	static int16_t f, ddF_x, ddF_y, x, y, run;
 
 	f = 1 - r;
 	ddF_x = 1;
 	ddF_y = -2 * r;
 	x = 0;
 	y = r;
-
-	ILI9341DrawPixel(x0, y0 + r, color);
-	ILI9341DrawPixel(x0, y0 - r, color);
-	ILI9341DrawPixel(x0 + r, y0, color);
-	ILI9341DrawPixel(x0 - r, y0, color);
-
-    while (x < y){
-        if (f >= 0){
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        ILI9341DrawPixel(x0 + x, y0 + y, color);
-        ILI9341DrawPixel(x0 - x, y0 + y, color);
-        ILI9341DrawPixel(x0 + x, y0 - y, color);
-        ILI9341DrawPixel(x0 - x, y0 - y, color);
-
-        ILI9341DrawPixel(x0 + y, y0 + x, color);
-        ILI9341DrawPixel(x0 - y, y0 + x, color);
-        ILI9341DrawPixel(x0 + y, y0 - x, color);
-        ILI9341DrawPixel(x0 - y, y0 - x, color);
-    }
+	run = 0;
+
+	while (x < y){
+		if (f >= 0){
+			/* y changes: points run..x share the same distance y */
+			CircleSpans(x0, y0, run, x, y, color);
+			run = x + 1;
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+	}
+	CircleSpans(x0, y0, run, x, y, color);
 }
 
 void ILI9341DrawFilledCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
@@ -655,179 +1487,166 @@ void ILI9341DrawFilledCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
 	x = 0;
 	y = r;
 
-    ILI9341DrawPixel(x0, y0 + r, color);
-    ILI9341DrawPixel(x0, y0 - r, color);
-    ILI9341DrawPixel(x0 + r, y0, color);
-    ILI9341DrawPixel(x0 - r, y0, color);
-    ILI9341DrawLine(x0 - r, y0, x0 + r, y0, color);
-
-    while (x < y){
-        if (f >= 0){
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        ILI9341DrawLine(x0 - x, y0 + y, x0 + x, y0 + y, color);
-        ILI9341DrawLine(x0 + x, y0 - y, x0 - x, y0 - y, color);
-
-        ILI9341DrawLine(x0 + y, y0 + x, x0 - y, y0 + x, color);
-        ILI9341DrawLine(x0 + y, y0 - x, x0 - y, y0 - x, color);
-    }
+	/* Center row */
+	Span(x0 - r, y0, x0 + r, y0, color);
+	while (x < y){
+		if (f >= 0){
+			/* Rows at distance y are only drawn once, with the widest x of the run */
+			Span(x0 - x, y0 + y, x0 + x, y0 + y, color);
+			Span(x0 - x, y0 - y, x0 + x, y0 - y, color);
+			y--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x++;
+		ddF_x += 2;
+		f += ddF_x;
+		/* Rows at distance x (one per step) */
+		if (x <= y){
+			Span(x0 - y, y0 + x, x0 + y, y0 + x, color);
+			Span(x0 - y, y0 - x, x0 + y, y0 - x, color);
+		}
+	}
+	/* Last run, unless its rows were already drawn as rows at distance x */
+	if (x < y){
+		Span(x0 - x, y0 + y, x0 + x, y0 + y, color);
+		Span(x0 - x, y0 - y, x0 + x, y0 - y, color);
+	}
 }
 
 void ILI9341DrawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
-	ILI9341DrawLine(x0, y0, x1, y1, color);
-	ILI9341DrawLine(x0, y0, x2, y2, color);
-	ILI9341DrawLine(x1, y1, x2, y2, color);
+	LineRuns(x0, y0, x1, y1, 1, color);
+	LineRuns(x0, y0, x2, y2, 1, color);
+	LineRuns(x1, y1, x2, y2, 1, color);
 }
 
 void ILI9341DrawFilledTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
-	static int16_t x_0 = 0;
-	static int16_t y_0 = 0;
-	static int16_t x_1 = 0;
-	static int16_t y_1 = 0;
-	static int16_t x_2 = 0;
-	static int16_t y_2 = 0;
-	static int16_t x_aux = 0;
-	static int16_t y_aux = 0;
-	static int16_t scanline_y = 0;
-	float invslope1, invslope2, curx1, curx2;
-	if((y0 <= y1) && (y0 <= y2)){
-		x_0 = x0;
-		y_0 = y0;
-		if(y1 <= y2){
-			x_1 = x1;
-			y_1 = y1;
-			x_2 = x2;
-			y_2 = y2;
-		} else{
-			x_1 = x2;
-			y_1 = y2;
-			x_2 = x1;
-			y_2 = y1;
-		}
-	}else if((y1 <= y2) && (y1 <= y0)){
-		x_0 = x1;
-		y_0 = y1;
-		if(y0 <= y2){
-			x_1 = x0;
-			y_1 = y0;
-			x_2 = x2;
-			y_2 = y2;
-		} else{
-			x_1 = x2;
-			y_1 = y2;
-			x_2 = x0;
-			y_2 = y0;
-		}
-	}else if((y2 <= y1) && (y2 <= y0)){
-		x_0 = x2;
-		y_0 = y2;
-		if(y0 <= y1){
-			x_1 = x0;
-			y_1 = y0;
-			x_2 = x1;
-			y_2 = y1;
-		} else{
-			x_1 = x1;
-			y_1 = y1;
-			x_2 = x0;
-			y_2 = y0;
-		}
-	}
-	if(y_1 == y_2){
-		// Bottom flat triangle
-		invslope1 = (float)(x_1 - x_0) / (float)(y_1 - y_0);
-		invslope2 = (float)(x_2 - x_0) / (float)(y_2 - y_0);
-		curx1 = x_0;
-		curx2 = x_0;
-		scanline_y = y_0;
-		while(scanline_y < y_1){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 += invslope1;
-			curx2 += invslope2;
-			scanline_y++;
-		}
-  	}
-  	else if (y_0 == y_1){
-		// Top flat triangle
-		invslope1 = (float)(x_2 - x_0) / (float)(y_2 - y_0);
-		invslope2 = (float)(x_2 - x_1) / (float)(y_2 - y_1);
-		curx1 = x_2;
-		curx2 = x_2;
-		scanline_y = y_2;
-		while(scanline_y > y_0){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 -= invslope1;
-			curx2 -= invslope2;
-			scanline_y--;
-		}
-  	}
-  	else{
-		// Split in a flat top triangle and a bottom flat triangle
-		x_aux = (int)(x_0 + (float)(y_1 - y_0) / (float)(y_2 - y_0) * (x_2 - x_0));
-		y_aux = y_1;
-		// Bottom flat triangle
-		invslope1 = (float)(x_1 - x_0) / (float)(y_1 - y_0);
-		invslope2 = (float)(x_aux - x_0) / (float)(y_aux - y_0);
-		curx1 = x_0;
-		curx2 = x_0;
-		scanline_y = y_0;
-		while(scanline_y < y_1){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 += invslope1;
-			curx2 += invslope2;
-			scanline_y++;
-		}
-		// Top flat triangle
-		invslope1 = (float)(x_2 - x_1) / (float)(y_2 - y_1);
-		invslope2 = (float)(x_2 - x_aux) / (float)(y_2 - y_aux);
-		curx1 = x_2;
-		curx2 = x_2;
-		scanline_y = y_2;
-		while(scanline_y > y_1){
-			ILI9341DrawLine((int)curx1, scanline_y, (int)curx2, scanline_y, color);
-			curx1 -= invslope1;
-			curx2 -= invslope2;
-			scanline_y--;
-		}
-		ILI9341DrawLine(x_1, y_1, x_aux, y_aux, color);
-  	}
+	int16_t aux, y, xa, xb, last;
+
+	/* Sort vertices by y (y0 <= y1 <= y2) */
+	if (y0 > y1){
+		aux = y0; y0 = y1; y1 = aux;
+		aux = x0; x0 = x1; x1 = aux;
+	}
+	if (y1 > y2){
+		aux = y1; y1 = y2; y2 = aux;
+		aux = x1; x1 = x2; x2 = aux;
+	}
+	if (y0 > y1){
+		aux = y0; y0 = y1; y1 = aux;
+		aux = x0; x0 = x1; x1 = aux;
+	}
+	/* All vertices in the same row */
+	if (y0 == y2){
+		xa = x0;
+		xb = x0;
+		if (x1 < xa) xa = x1;
+		if (x1 > xb) xb = x1;
+		if (x2 < xa) xa = x2;
+		if (x2 > xb) xb = x2;
+		Span(xa, y0, xb, y0, color);
+		return;
+	}
+	/* Upper part: edges 0-1 and 0-2 (row y1 included only if it is the bottom) */
+	last = (y1 == y2) ? y1 : y1 - 1;
+	for (y = y0; y <= last; y++){
+		xa = x0 + (int32_t)(x1 - x0) * (y - y0) / ((y1 != y0) ? (y1 - y0) : 1);
+		xb = x0 + (int32_t)(x2 - x0) * (y - y0) / (y2 - y0);
+		if (y1 == y0){
+			xa = x1;
+		}
+		Span(xa, y, xb, y, color);
+	}
+	/* Lower part: edges 1-2 and 0-2 */
+	for (; y <= y2; y++){
+		xa = x1 + (int32_t)(x2 - x1) * (y - y1) / (y2 - y1);
+		xb = x0 + (int32_t)(x2 - x0) * (y - y0) / (y2 - y0);
+		Span(xa, y, xb, y, color);
+	}
 }
 
 void ILI9341DrawPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pic){
-	static uint16_t i, j;
-	static int32_t bytes_count;
-	static uint8_t pixel[MAX_VALUE_SIZE];
+	SetCursorPosition(x, y, x + width - 1, y + height - 1);
+	if (fb.buffer != NULL){
+		/* Copied into the band by the CPU: no DMA from flash */
+		lcd_cmd_t lcd_pixels = {NULL, (uint32_t)width * height * 2, (uint8_t *)pic};
+		WriteLCD(&lcd_pixels);
+		return;
+	}
+	/* Flash is not DMA capable: the picture is copied into DMA buffers, every one 
+	 * is sent while the next one is filled */
+	DrawStrips(width, height, PictureFill, (void *)pic);
+}
+
+bool ILI9341GetQoiSize(const uint8_t* qoi, uint32_t size, uint16_t* width, uint16_t* height){
+	uint32_t w, h;
+
+	if (!QoiGetSize(qoi, size, &w, &h)){
+		return false;
+	}
+	if ((w == 0) || (h == 0) || (w > FB_MAX_WIDTH) || (h > FB_MAX_WIDTH)){
+		return false;
+	}
+	*width = w;
+	*height = h;
+	return true;
+}
+
+bool ILI9341DrawQoi(uint16_t x, uint16_t y, const uint8_t* qoi, uint32_t size){
+	uint16_t width, height;
+
+	if (!ILI9341GetQoiSize(qoi, size, &width, &height)){
+		return false;
+	}
+	QoiDecoderInit(&qoi_dec, qoi, size);
 
 	SetCursorPosition(x, y, x + width - 1, y + height - 1);
 
-	/* Number of bytes to write. We have to write 2 bytes/pixel */
-	bytes_count = width * height * 2;
+	/* Rows are decoded into one DMA buffer while the other one is being sent */
+	DrawStrips(width, height, QoiFill, &qoi_dec);
+	return true;
+}
 
-	/* Start writing LCD memory */
-	lcd_cmd_t lcd_write = {MEM_WRITE, NULL, NULL};
-	WriteLCD(&lcd_write);
+bool ILI9341FramebufferInit(uint16_t band_lines, uint16_t background){
+	ILI9341FramebufferDeInit();
+	if (band_lines == 0){
+		return false;
+	}
+	fb.buffer = heap_caps_malloc((uint32_t)band_lines * FB_MAX_WIDTH * 2, MALLOC_CAP_DMA);
+	if (fb.buffer == NULL){
+		return false;
+	}
+	fb.band_lines = band_lines;
+	fb.background = background;
+	fb.band_y = 0;
+	FramebufferBand();
+	return true;
+}
 
-	j = 0;
-	while(bytes_count - MAX_VALUE_SIZE > 0){
-		for (i = 0; i < MAX_VALUE_SIZE; i++){
-			pixel[i] = pic[j * MAX_VALUE_SIZE + i];
-		}
-		lcd_cmd_t lcd_pixel = {NULL, MAX_VALUE_SIZE, pixel};
-		WriteLCD(&lcd_pixel);
-		bytes_count -= MAX_VALUE_SIZE;
-		j++;
+void ILI9341FramebufferDeInit(void){
+	if (fb.buffer != NULL){
+		heap_caps_free(fb.buffer);
+		fb.buffer = NULL;
 	}
-	for (i = 0; i < bytes_count; i++){
-		pixel[i] = pic[j * MAX_VALUE_SIZE + i];
+}
+
+bool ILI9341Flush(void){
+	bool next_band;
+
+	if (fb.buffer == NULL){
+		return false;
 	}
-	lcd_cmd_t lcd_pixel = {NULL, bytes_count, pixel};
-	WriteLCD(&lcd_pixel);
+	for (uint8_t i = 0; i < fb.dirty_qty; i++){
+		FramebufferSendRect(&fb.dirty[i]);
+	}
+	/* Move to next band (or back to first one when the pass is complete) */
+	fb.band_y += fb.band_h;
+	next_band = (fb.band_y < lcd_orientation.height);
+	if (!next_band){
+		fb.band_y = 0;
+	}
+	FramebufferBand();
+	return next_band;
 }
 
 uint8_t ILI9341DeInit(void){
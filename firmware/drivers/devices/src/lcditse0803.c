@@ -22,15 +22,13 @@
 #define GPIO_SEL_3	GPIO_9
 /*==================[internal data definition]===============================*/
 static uint16_t actual_value = 0; /*variable that saves the value to be shown in the display LCD*/
+static gpio_mask_t bcd_pins; /*BCD data pins, written all together*/
 /*==================[internal functions declaration]=========================*/
 /** @brief Aux function to load a digit to the LCD Display
  *
  */
 bool LcdItsE0803BCDtoPin(uint8_t value){
-	GPIOState(GPIO_BCD_1, (value & (1<<0))>>0);
-	GPIOState(GPIO_BCD_2, (value & (1<<1))>>1);
-	GPIOState(GPIO_BCD_3, (value & (1<<2))>>2);
-	GPIOState(GPIO_BCD_4, (value & (1<<3))>>3);
+	GPIOWriteMask(&bcd_pins, value);
 	return true;
 }
 /*==================[external functions definition]==========================*/
@@ -40,6 +38,8 @@ bool LcdItsE0803Init(void){
 	GPIOInit(GPIO_BCD_2, GPIO_OUTPUT);
 	GPIOInit(GPIO_BCD_3, GPIO_OUTPUT);
 	GPIOInit(GPIO_BCD_4, GPIO_OUTPUT);
+	const gpio_t bcd_list[] = {GPIO_BCD_1, GPIO_BCD_2, GPIO_BCD_3, GPIO_BCD_4};
+	GPIOMaskInit(&bcd_pins, bcd_list, sizeof(bcd_list)/sizeof(gpio_t));
 
 	/* Configuration of pins of control*/
 	GPIOInit(GPIO_SEL_1, GPIO_OUTPUT);
@@ -13,32 +13,59 @@
 #include "mpu6050.h"
 #include "math.h"
 #include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
 /*==================[macros and definitions]=================================*/
-#define I2C_NUM I2C_NUM_0
+#define STREAM_MASK         (MPU6050_STREAM_BUFFER_SIZE - 1)
+#define STREAM_BURST_FRAMES 18      // frames per burst read (252 bytes)
+#define STREAM_STACK_SIZE   3072
+#define STREAM_COUNT_TRIES  3       // FIFO count reads until no data ready falls in between
+#define DMP_SKIP_CHUNK      255     // bytes per burst read when discarding old DMP packets
+#define HMC5883L_ADDRESS    0x1E
+#define HMC5883L_RA_CONFIG_A    0x00
+#define HMC5883L_RA_CONFIG_B    0x01
+#define HMC5883L_RA_MODE        0x02
+#define HMC5883L_RA_DATAX_H     0x03    // X, Z, Y order, big endian
+#define AK8963_ADDRESS      0x0C
+#define AK8963_RA_HXL           0x03    // X, Y, Z order, little endian, followed by ST2
+#define AK8963_RA_CNTL1         0x0A
 
 /*==================[internal data definition]===============================*/
 uint8_t devAddr;
 uint8_t buffer[14];
+static TaskHandle_t stream_task = NULL;                 /*!< Task that reads the FIFO */
+static SemaphoreHandle_t stream_available = NULL;       /*!< Given when the ring stops being empty */
+static mpu6050_stream_config_t stream_config;
+static mpu6050_sample_t stream_buffer[MPU6050_STREAM_BUFFER_SIZE];
+static volatile uint16_t stream_head = 0;               /*!< Written only by stream task */
+static volatile uint16_t stream_tail = 0;               /*!< Written only by reader */
+static volatile uint8_t stream_pending = 0;             /*!< Samples since last burst (ISR) */
+static volatile int64_t stream_last_us = 0;             /*!< Last data ready time (ISR) */
+static portMUX_TYPE stream_mux = portMUX_INITIALIZER_UNLOCKED; /*!< 64 bits stream_last_us access */
+static uint32_t stream_period_us;
+static uint32_t stream_overflows = 0;
+static bool stream_running = false;
+static mpu6050_mag_t mag_type = MPU6050_MAG_NONE;      /*!< Magnetometer read by Slave 0 */
+static uint8_t mag_length = 0;                          /*!< Bytes read by Slave 0 */
+static mpu6050_dmp_config_t dmp_config;                 /*!< Loaded DMP firmware packet layout */
+static bool dmp_running = false;                        /*!< DMP enabled (it owns the FIFO and INT pin) */
+static float dmp_accel_lsb = 16384;                     /*!< Acceleration LSB per g */
+static uint8_t dmp_discard[DMP_SKIP_CHUNK];             /*!< Old DMP packets (not used) */
+static TaskHandle_t event_task = NULL;                  /*!< Task that reads the interrupt status */
+static QueueHandle_t event_queue = NULL;
+static mpu6050_event_config_t event_config;
+static volatile int64_t event_last_us = 0;              /*!< Last INT pin edge time (ISR) */
+static bool events_running = false;
 /*==================[internal functions declaration]=========================*/
 
 /*==================[external functions definition]==========================*/
 void MPU6050_ReadRegister(uint8_t reg, uint8_t *data, uint8_t len){
-	uint8_t dev = 0x68;
-	i2c_cmd_handle_t cmd;
-	I2C_SelectRegister(dev, reg);
-
-	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (dev << 1) | I2C_MASTER_READ, 1));
-
-	if(len>1)
-		ESP_ERROR_CHECK(i2c_master_read(cmd, data, len, I2C_MASTER_ACK));
-
-	ESP_ERROR_CHECK(i2c_master_read_byte(cmd, data+len-1, I2C_MASTER_NACK));
-
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000));
-	i2c_cmd_link_delete(cmd);
+	I2C_readBytes(devAddr, reg, len, data, I2C_MASTER_TIMEOUT_MS);
 }
 
 void MPU6050_Address(uint8_t address) {
@@ -53,6 +80,24 @@ void MPU6050_initialize() {
     MPU6050_setSleepEnabled(false); // thanks to Jack Elston for pointing this one out!
 }
 
+bool MPU6050_setRegisterCache(bool enabled) {
+	if (!enabled) {
+		I2C_cacheDisable(devAddr);
+		return true;
+	}
+	if (!I2C_cacheEnable(devAddr)) {
+		return false;
+	}
+	/* Registers changed by the device or with self-clearing bits */
+	I2C_cacheVolatile(devAddr, MPU6050_RA_I2C_SLV4_CTRL, MPU6050_RA_I2C_MST_STATUS - MPU6050_RA_I2C_SLV4_CTRL + 1);
+	I2C_cacheVolatile(devAddr, MPU6050_RA_INT_STATUS, MPU6050_RA_MOT_DETECT_STATUS - MPU6050_RA_INT_STATUS + 1);
+	I2C_cacheVolatile(devAddr, MPU6050_RA_SIGNAL_PATH_RESET, 1);
+	I2C_cacheVolatile(devAddr, MPU6050_RA_USER_CTRL, 1);
+	I2C_cacheVolatile(devAddr, MPU6050_RA_BANK_SEL, MPU6050_RA_FIFO_R_W - MPU6050_RA_BANK_SEL + 1);
+	/* Load the configuration registers, skipping the ones with read side effects */
+	return I2C_cacheLoad(devAddr, 0, MPU6050_RA_WHO_AM_I + 1);
+}
+
 /** Verify the I2C connection.
  * Make sure the device is connected and responds as expected.
  * @return True if connection is valid, false otherwise
@@ -1743,7 +1788,7 @@ bool MPU6050_getIntDataReadyStatus() {
 // ACCEL_*OUT_* registers
 
 /** Get raw 9-axis motion sensor readings (accel/gyro/compass).
- * FUNCTION NOT FULLY IMPLEMENTED YET.
+ * The outputs are left untouched if the sensors could not be read.
  * @param ax 16-bit signed integer container for accelerometer X-axis value
  * @param ay 16-bit signed integer container for accelerometer Y-axis value
  * @param az 16-bit signed integer container for accelerometer Z-axis value
@@ -1759,8 +1804,19 @@ bool MPU6050_getIntDataReadyStatus() {
  * @see MPU6050_RA_ACCEL_XOUT_H
  */
 void MPU6050_getMotion9(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int16_t* gy, int16_t* gz, int16_t* mx, int16_t* my, int16_t* mz) {
-    MPU6050_getMotion6(ax, ay, az, gx, gy, gz);
-    // TODO: magnetometer integration
+    mpu6050_motion9_t data;
+    if (!MPU6050_readMotion9(&data)) {
+        return;
+    }
+    *ax = data.accel[0];
+    *ay = data.accel[1];
+    *az = data.accel[2];
+    *gx = data.gyro[0];
+    *gy = data.gyro[1];
+    *gz = data.gyro[2];
+    *mx = data.mag[0];
+    *my = data.mag[1];
+    *mz = data.mag[2];
 }
 /** Get raw 6-axis motion sensor readings (accel/gyro).
  * Retrieves all currently available motion sensor values.
@@ -2409,6 +2465,11 @@ void MPU6050_resetSensors() {
  */
 void MPU6050_reset() {
     I2C_writeBit(devAddr, MPU6050_RA_PWR_MGMT_1, MPU6050_PWR1_DEVICE_RESET_BIT, true);
+    /* The reset bit (and any deferred write) must reach the device before the cache is dropped */
+    I2C_cacheCommit(devAddr);
+    /* All registers go back to their reset values */
+    I2C_cacheInvalidate(devAddr);
+    dmp_running = false;
 }
 /** Get sleep mode status.
  * Setting the SLEEP bit in the register puts the device into very low power
@@ -2766,4 +2827,522 @@ void MPU6050_setDeviceID(uint8_t id) {
     I2C_writeBits(devAddr, MPU6050_RA_WHO_AM_I, MPU6050_WHO_AM_I_BIT, MPU6050_WHO_AM_I_LENGTH, id);
 }
 
+// Auxiliary bus magnetometer
+
+bool MPU6050_magInit(mpu6050_mag_t mag) {
+    uint8_t mag_addr, mag_reg;
+    bool ok;
+    MPU6050_setSlaveEnabled(0, false);
+    mag_type = MPU6050_MAG_NONE;
+    mag_length = 0;
+    if (mag == MPU6050_MAG_NONE) {
+        return true;
+    }
+    /* Magnetometer configuration straight from the main bus */
+    MPU6050_setI2CMasterModeEnabled(false);
+    MPU6050_setI2CBypassEnabled(true);
+    if (mag == MPU6050_MAG_HMC5883L) {
+        mag_addr = HMC5883L_ADDRESS;
+        mag_reg = HMC5883L_RA_DATAX_H;
+        ok = I2C_writeByte(mag_addr, HMC5883L_RA_CONFIG_A, 0x18)    // 1 average, 75 Hz
+            && I2C_writeByte(mag_addr, HMC5883L_RA_CONFIG_B, 0x20)  // +/-1.3 Ga
+            && I2C_writeByte(mag_addr, HMC5883L_RA_MODE, 0x00);     // continuous measurement
+        mag_length = 6;
+    } else {
+        mag_addr = AK8963_ADDRESS;
+        mag_reg = AK8963_RA_HXL;
+        ok = I2C_writeByte(mag_addr, AK8963_RA_CNTL1, 0x16);        // 16 bits, continuous 100 Hz
+        mag_length = 7;     // ST2 must be read to release the next measurement
+    }
+    MPU6050_setI2CBypassEnabled(false);
+    if (!ok) {
+        mag_length = 0;
+        return false;
+    }
+    /* Slave 0 reads the magnetometer on every sample */
+    MPU6050_setMasterClockSpeed(MPU6050_CLOCK_DIV_400);
+    MPU6050_setWaitForExternalSensorEnabled(true);
+    MPU6050_setSlaveAddress(0, (1 << MPU6050_I2C_SLV_RW_BIT) | mag_addr);
+    MPU6050_setSlaveRegister(0, mag_reg);
+    MPU6050_setSlaveDataLength(0, mag_length);
+    MPU6050_setSlaveEnabled(0, true);
+    MPU6050_setI2CMasterModeEnabled(true);
+    mag_type = mag;
+    return true;
+}
+
+bool MPU6050_readMotion9(mpu6050_motion9_t *data) {
+    uint8_t raw[MPU6050_MOTION9_SIZE + 7];
+    const uint8_t *mag = &raw[MPU6050_MOTION9_SIZE];
+    if (I2C_readBytes(devAddr, MPU6050_RA_ACCEL_XOUT_H, MPU6050_MOTION9_SIZE + mag_length, raw, I2C_MASTER_TIMEOUT_MS) == 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        data->accel[i] = (((int16_t)raw[2*i]) << 8) | raw[2*i + 1];
+        data->gyro[i] = (((int16_t)raw[8 + 2*i]) << 8) | raw[8 + 2*i + 1];
+    }
+    data->temp = (((int16_t)raw[6]) << 8) | raw[7];
+    switch (mag_type) {
+        case MPU6050_MAG_HMC5883L:
+            data->mag[0] = (((int16_t)mag[0]) << 8) | mag[1];
+            data->mag[2] = (((int16_t)mag[2]) << 8) | mag[3];
+            data->mag[1] = (((int16_t)mag[4]) << 8) | mag[5];
+            break;
+        case MPU6050_MAG_AK8963:
+            data->mag[0] = (((int16_t)mag[1]) << 8) | mag[0];
+            data->mag[1] = (((int16_t)mag[3]) << 8) | mag[2];
+            data->mag[2] = (((int16_t)mag[5]) << 8) | mag[4];
+            break;
+        default:
+            data->mag[0] = data->mag[1] = data->mag[2] = 0;
+            break;
+    }
+    return true;
+}
+
+// DMP
+
+/** Select DMP memory bank and start address. */
+static void MPU6050_setMemoryAddress(uint8_t bank, uint8_t address) {
+    I2C_writeByte(devAddr, MPU6050_RA_BANK_SEL, bank & 0x1F);
+    I2C_writeByte(devAddr, MPU6050_RA_MEM_START_ADDR, address);
+}
+
+bool MPU6050_writeMemoryBlock(const uint8_t *data, uint16_t size, uint8_t bank, uint8_t address, bool verify) {
+    uint8_t verify_buffer[MPU6050_DMP_MEMORY_CHUNK_SIZE];
+    uint16_t chunk;
+    for (uint16_t i = 0; i < size; i += chunk) {
+        chunk = MPU6050_DMP_MEMORY_CHUNK_SIZE;
+        if (chunk > size - i) chunk = size - i;
+        /* Chunks don't cross bank boundaries */
+        if (chunk > MPU6050_DMP_MEMORY_BANK_SIZE - address) chunk = MPU6050_DMP_MEMORY_BANK_SIZE - address;
+        MPU6050_setMemoryAddress(bank, address);
+        if (!I2C_writeBytes(devAddr, MPU6050_RA_MEM_R_W, chunk, (uint8_t *)&data[i])) {
+            return false;
+        }
+        if (verify) {
+            MPU6050_setMemoryAddress(bank, address);
+            if (I2C_readBytes(devAddr, MPU6050_RA_MEM_R_W, chunk, verify_buffer, I2C_MASTER_TIMEOUT_MS) == 0
+                || memcmp(&data[i], verify_buffer, chunk) != 0) {
+                return false;
+            }
+        }
+        address += chunk;
+        if (address == 0) {
+            bank++;
+        }
+    }
+    return true;
+}
+
+bool MPU6050_readMemoryBlock(uint8_t *data, uint16_t size, uint8_t bank, uint8_t address) {
+    uint16_t chunk;
+    for (uint16_t i = 0; i < size; i += chunk) {
+        chunk = MPU6050_DMP_MEMORY_CHUNK_SIZE;
+        if (chunk > size - i) chunk = size - i;
+        if (chunk > MPU6050_DMP_MEMORY_BANK_SIZE - address) chunk = MPU6050_DMP_MEMORY_BANK_SIZE - address;
+        MPU6050_setMemoryAddress(bank, address);
+        if (I2C_readBytes(devAddr, MPU6050_RA_MEM_R_W, chunk, &data[i], I2C_MASTER_TIMEOUT_MS) == 0) {
+            return false;
+        }
+        address += chunk;
+        if (address == 0) {
+            bank++;
+        }
+    }
+    return true;
+}
+
+bool MPU6050_dmpInitialize(const mpu6050_dmp_config_t *config) {
+    if (config->firmware == NULL || config->size > MPU6050_DMP_MEMORY_BANKS * MPU6050_DMP_MEMORY_BANK_SIZE
+        || config->packet_size < 16 || config->packet_size > 64 || config->accel_offset + 6 > config->packet_size) {
+        return false;
+    }
+    /* The stream and the events use the FIFO and the INT pin too */
+    if (stream_running || events_running) {
+        return false;
+    }
+    dmp_config = *config;
+    MPU6050_reset();
+    vTaskDelay(pdMS_TO_TICKS(30));
+    MPU6050_setSleepEnabled(false);
+    MPU6050_setClockSource(MPU6050_CLOCK_PLL_ZGYRO);
+    MPU6050_setIntEnabled((1 << MPU6050_INTERRUPT_FIFO_OFLOW_BIT) | (1 << MPU6050_INTERRUPT_DMP_INT_BIT));
+    MPU6050_setRate(config->rate_divider);
+    MPU6050_setDLPFMode(MPU6050_DLPF_BW_42);
+    MPU6050_setFullScaleGyroRange(MPU6050_GYRO_FS_2000);
+    if (!MPU6050_writeMemoryBlock(config->firmware, config->size, 0, 0, true)) {
+        return false;
+    }
+    I2C_writeByte(devAddr, MPU6050_RA_DMP_CFG_1, config->start_address >> 8);
+    I2C_writeByte(devAddr, MPU6050_RA_DMP_CFG_2, config->start_address & 0xFF);
+    I2C_writeByte(devAddr, MPU6050_RA_FIFO_EN, 0);  // DMP writes the FIFO by itself
+    MPU6050_resetFIFO();
+    MPU6050_setFIFOEnabled(true);
+    I2C_writeBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_DMP_RESET_BIT, true);
+    MPU6050_setDMPEnabled(true);
+    dmp_accel_lsb = 16384 >> MPU6050_getFullScaleAccelRange();
+    return true;
+}
+
+void MPU6050_setDMPEnabled(bool enabled) {
+    I2C_writeBit(devAddr, MPU6050_RA_USER_CTRL, MPU6050_USERCTRL_DMP_EN_BIT, enabled);
+    dmp_running = enabled;
+}
+
+bool MPU6050_dmpRead(mpu6050_dmp_data_t *data) {
+    uint8_t packet[64];
+    int32_t raw_q[4];
+    float accel[3];
+    float *q = data->q, *g = data->gravity;
+    uint16_t count = MPU6050_getFIFOCount();
+    uint16_t skip, chunk;
+    if (dmp_config.packet_size == 0 || count < dmp_config.packet_size) {
+        return false;
+    }
+    if (count >= MPU6050_FIFO_SIZE || count % dmp_config.packet_size != 0) {
+        MPU6050_resetFIFO();
+        return false;
+    }
+    /* Only the latest packet is used: older ones are discarded in bursts */
+    for (skip = count - dmp_config.packet_size; skip > 0; skip -= chunk) {
+        chunk = (skip > DMP_SKIP_CHUNK) ? DMP_SKIP_CHUNK : skip;
+        if (I2C_readBytes(devAddr, MPU6050_RA_FIFO_R_W, chunk, dmp_discard, I2C_MASTER_TIMEOUT_MS) == 0) {
+            return false;
+        }
+    }
+    if (I2C_readBytes(devAddr, MPU6050_RA_FIFO_R_W, dmp_config.packet_size, packet, I2C_MASTER_TIMEOUT_MS) == 0) {
+        return false;
+    }
+    /* Quaternion: 4 x 32 bits, Q30 */
+    for (uint8_t i = 0; i < 4; i++) {
+        raw_q[i] = (int32_t)(((uint32_t)packet[4*i] << 24) | ((uint32_t)packet[4*i + 1] << 16) | ((uint32_t)packet[4*i + 2] << 8) | packet[4*i + 3]);
+        q[i] = raw_q[i] / 1073741824.0f;
+    }
+    g[0] = 2 * (q[1] * q[3] - q[0] * q[2]);
+    g[1] = 2 * (q[0] * q[1] + q[2] * q[3]);
+    g[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        accel[i] = (int16_t)((packet[dmp_config.accel_offset + 2*i] << 8) | packet[dmp_config.accel_offset + 2*i + 1]) / dmp_accel_lsb;
+        data->linear_accel[i] = accel[i] - g[i];
+    }
+    return true;
+}
+
+// Motion events
+
+/** INT pin rising edge: interrupt status must be read. */
+static void IRAM_ATTR MPU6050_eventIsr(void *args) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    event_last_us = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(event_task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/** Queue an event, the oldest one is discarded if the queue is full. */
+static void MPU6050_eventPush(mpu6050_event_type_t type, uint8_t motion_status, int64_t time_us) {
+    mpu6050_event_t event = {.type = type, .motion_status = motion_status, .time_us = time_us};
+    mpu6050_event_t old;
+    if (xQueueSend(event_queue, &event, 0) != pdTRUE) {
+        xQueueReceive(event_queue, &old, 0);
+        xQueueSend(event_queue, &event, 0);
+    }
+}
+
+/** Read the interrupt and motion status and queue the events. */
+static void MPU6050_eventTask(void *args) {
+    uint8_t int_status, motion_status;
+    i2c_read_t reads[2] = {
+        {.regAddr = MPU6050_RA_INT_STATUS, .length = 1, .data = &int_status},
+        {.regAddr = MPU6050_RA_MOT_DETECT_STATUS, .length = 1, .data = &motion_status},
+    };
+    while (events_running) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) {
+            continue;
+        }
+        reads[0].devAddr = reads[1].devAddr = devAddr;
+        /* Reading INT_STATUS releases the latched INT pin */
+        if (!I2C_readBytesMulti(reads, 2, 0)) {
+            continue;
+        }
+        if (int_status & (1 << MPU6050_INTERRUPT_FF_BIT)) {
+            MPU6050_eventPush(MPU6050_EVENT_FREEFALL, motion_status, event_last_us);
+        }
+        if (int_status & (1 << MPU6050_INTERRUPT_MOT_BIT)) {
+            MPU6050_eventPush(MPU6050_EVENT_MOTION, motion_status, event_last_us);
+        }
+        if (int_status & (1 << MPU6050_INTERRUPT_ZMOT_BIT)) {
+            MPU6050_eventPush((motion_status & (1 << MPU6050_MOTION_MOT_ZRMOT_BIT)) ? MPU6050_EVENT_STILL : MPU6050_EVENT_STILL_END,
+                motion_status, event_last_us);
+        }
+    }
+    event_task = NULL;
+    vTaskDelete(NULL);
+}
+
+bool MPU6050_eventsStart(const mpu6050_event_config_t *config) {
+    uint8_t int_enabled = 0;
+    /* Only one of events, stream and DMP can own the INT pin configuration */
+    if (events_running || event_task != NULL || stream_running || dmp_running) {
+        return false;
+    }
+    event_config = *config;
+    if (event_queue == NULL) {
+        event_queue = xQueueCreate(MPU6050_EVENT_QUEUE_SIZE, sizeof(mpu6050_event_t));
+    }
+    /* Motion detection works on the high pass filtered acceleration */
+    MPU6050_setDHPFMode(MPU6050_DHPF_5);
+    if (config->motion_threshold > 0) {
+        MPU6050_setMotionDetectionThreshold(config->motion_threshold);
+        MPU6050_setMotionDetectionDuration(config->motion_duration);
+        int_enabled |= 1 << MPU6050_INTERRUPT_MOT_BIT;
+    }
+    if (config->zero_motion_threshold > 0 && !config->cycle_mode) {
+        MPU6050_setZeroMotionDetectionThreshold(config->zero_motion_threshold);
+        MPU6050_setZeroMotionDetectionDuration(config->zero_motion_duration);
+        int_enabled |= 1 << MPU6050_INTERRUPT_ZMOT_BIT;
+    }
+    if (config->freefall_threshold > 0 && !config->cycle_mode) {
+        MPU6050_setFreefallDetectionThreshold(config->freefall_threshold);
+        MPU6050_setFreefallDetectionDuration(config->freefall_duration);
+        int_enabled |= 1 << MPU6050_INTERRUPT_FF_BIT;
+    }
+    /* INT pin: active high, push-pull, latched until INT_STATUS is read */
+    MPU6050_setInterruptMode(false);
+    MPU6050_setInterruptDrive(false);
+    MPU6050_setInterruptLatch(true);
+    MPU6050_setInterruptLatchClear(false);
+    MPU6050_setIntEnabled(int_enabled);
+
+    events_running = true;
+    if (xTaskCreate(MPU6050_eventTask, "mpu6050_ev", STREAM_STACK_SIZE, NULL, config->priority, &event_task) != pdPASS) {
+        events_running = false;
+        return false;
+    }
+    GPIOInit(config->int_pin, GPIO_INPUT);
+    GPIOActivInt(config->int_pin, MPU6050_eventIsr, true, NULL);
+    /* Pending status from before would keep the latched pin high */
+    xTaskNotifyGive(event_task);
+
+    if (config->cycle_mode) {
+        /* Accelerometer only, sampled at the wake frequency */
+        MPU6050_setStandbyXGyroEnabled(true);
+        MPU6050_setStandbyYGyroEnabled(true);
+        MPU6050_setStandbyZGyroEnabled(true);
+        MPU6050_setTempSensorEnabled(false);
+        MPU6050_setWakeFrequency(config->wake_frequency);
+        MPU6050_setWakeCycleEnabled(true);
+    }
+    return true;
+}
+
+void MPU6050_eventsStop() {
+    if (!events_running) {
+        return;
+    }
+    GPIODeactivInt(event_config.int_pin);
+    events_running = false;
+    MPU6050_setIntEnabled(0);
+    if (event_config.cycle_mode) {
+        MPU6050_setWakeCycleEnabled(false);
+        MPU6050_setTempSensorEnabled(true);
+        MPU6050_setStandbyXGyroEnabled(false);
+        MPU6050_setStandbyYGyroEnabled(false);
+        MPU6050_setStandbyZGyroEnabled(false);
+    }
+}
+
+bool MPU6050_eventRead(mpu6050_event_t *event, uint32_t timeout_ms) {
+    if (event_queue == NULL) {
+        return false;
+    }
+    return xQueueReceive(event_queue, event, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void MPU6050_eventsSleep(uint32_t max_ms) {
+    if (!events_running) {
+        return;
+    }
+    GPIOWakeUpEnable(event_config.int_pin, true);
+    if (max_ms > 0) {
+        esp_sleep_enable_timer_wakeup((uint64_t)max_ms * 1000);
+    } else {
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    }
+    esp_light_sleep_start();
+    /* INT is latched: a level interruption would fire until the task reads INT_STATUS */
+    GPIOWakeUpDisable(event_config.int_pin);
+    /* Edge interruptions are not seen during light sleep */
+    if (GPIORead(event_config.int_pin)) {
+        event_last_us = esp_timer_get_time();
+        xTaskNotifyGive(event_task);
+    }
+}
+
+// Streaming mode
+
+/** INT pin rising edge: one new sample in the FIFO. */
+static void IRAM_ATTR MPU6050_streamIsr(void *args) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    int64_t time_us = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&stream_mux);
+    stream_last_us = time_us;
+    portEXIT_CRITICAL_ISR(&stream_mux);
+    if (++stream_pending >= stream_config.watermark) {
+        stream_pending = 0;
+        vTaskNotifyGiveFromISR(stream_task, &higher_priority_task_woken);
+    }
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/** Last data ready time, read in one piece. */
+static int64_t MPU6050_streamLastUs(void) {
+    int64_t time_us;
+    portENTER_CRITICAL(&stream_mux);
+    time_us = stream_last_us;
+    portEXIT_CRITICAL(&stream_mux);
+    return time_us;
+}
+
+/** Store a parsed frame in the ring. */
+static void MPU6050_streamPush(const uint8_t *frame, int64_t time_us) {
+    uint16_t head = stream_head;
+    mpu6050_sample_t *sample = &stream_buffer[head];
+    if (((head + 1) & STREAM_MASK) == stream_tail) {
+        stream_overflows++;
+        return;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        sample->accel[i] = (((int16_t)frame[2*i]) << 8) | frame[2*i + 1];
+        sample->gyro[i] = (((int16_t)frame[8 + 2*i]) << 8) | frame[8 + 2*i + 1];
+    }
+    sample->temp = (((int16_t)frame[6]) << 8) | frame[7];
+    sample->time_us = time_us;
+    stream_head = (head + 1) & STREAM_MASK;
+    if (head == stream_tail) {
+        xSemaphoreGive(stream_available);
+    }
+}
+
+/** Read all the complete frames in the FIFO. */
+static void MPU6050_streamTask(void *args) {
+    static uint8_t fifo[STREAM_BURST_FRAMES * MPU6050_STREAM_FRAME_SIZE];
+    uint16_t count, frames, burst;
+    int64_t time_us;
+    uint8_t tries;
+    while (stream_running) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) {
+            continue;
+        }
+        /* A data ready between the two reads may or may not be in the count: read it again */
+        tries = 0;
+        do {
+            time_us = MPU6050_streamLastUs();
+            count = MPU6050_getFIFOCount();
+        } while ((time_us != MPU6050_streamLastUs()) && (++tries < STREAM_COUNT_TRIES));
+        if (count >= MPU6050_FIFO_SIZE || count % MPU6050_STREAM_FRAME_SIZE != 0) {
+            /* Oldest data was overwritten: frames are no longer aligned */
+            stream_overflows += count / MPU6050_STREAM_FRAME_SIZE;
+            MPU6050_resetFIFO();
+            stream_pending = 0;
+            continue;
+        }
+        frames = count / MPU6050_STREAM_FRAME_SIZE;
+        /* Last frame in the FIFO was taken at the last data ready */
+        time_us -= (int64_t)(frames - 1) * stream_period_us;
+        while (frames > 0) {
+            burst = (frames > STREAM_BURST_FRAMES) ? STREAM_BURST_FRAMES : frames;
+            if (I2C_readBytes(devAddr, MPU6050_RA_FIFO_R_W, burst * MPU6050_STREAM_FRAME_SIZE, fifo, I2C_MASTER_TIMEOUT_MS) == 0) {
+                break;
+            }
+            for (uint16_t i = 0; i < burst; i++) {
+                MPU6050_streamPush(&fifo[i * MPU6050_STREAM_FRAME_SIZE], time_us);
+                time_us += stream_period_us;
+            }
+            frames -= burst;
+        }
+    }
+    stream_task = NULL;
+    vTaskDelete(NULL);
+}
+
+bool MPU6050_streamStart(const mpu6050_stream_config_t *config) {
+    uint8_t divider;
+    if (stream_running || stream_task != NULL || events_running || dmp_running || config->rate_hz == 0 || config->watermark == 0) {
+        return false;
+    }
+    stream_config = *config;
+    if (stream_config.rate_hz > 1000) {
+        stream_config.rate_hz = 1000;
+    }
+    /* SMPLRT_DIV is 8 bits: 1000 / 256 rounded up is the slowest rate */
+    if (stream_config.rate_hz < 4) {
+        stream_config.rate_hz = 4;
+    }
+    if (stream_config.watermark > MPU6050_STREAM_BUFFER_SIZE) {
+        stream_config.watermark = MPU6050_STREAM_BUFFER_SIZE;
+    }
+    if (stream_available == NULL) {
+        stream_available = xSemaphoreCreateBinary();
+    }
+    /* Gyroscope output rate is 1 kHz with DLPF enabled */
+    divider = (1000 / stream_config.rate_hz) - 1;
+    stream_period_us = 1000000UL * (divider + 1) / 1000;
+    MPU6050_setDLPFMode(MPU6050_DLPF_BW_188);
+    MPU6050_setRate(divider);
+    /* INT pin: active high, push-pull, 50us pulse on each data ready */
+    MPU6050_setInterruptMode(false);
+    MPU6050_setInterruptDrive(false);
+    MPU6050_setInterruptLatch(false);
+    MPU6050_setIntEnabled(1 << MPU6050_INTERRUPT_DATA_RDY_BIT);
+    I2C_writeByte(devAddr, MPU6050_RA_FIFO_EN, (1 << MPU6050_TEMP_FIFO_EN_BIT) | (1 << MPU6050_XG_FIFO_EN_BIT) |
+        (1 << MPU6050_YG_FIFO_EN_BIT) | (1 << MPU6050_ZG_FIFO_EN_BIT) | (1 << MPU6050_ACCEL_FIFO_EN_BIT));
+    MPU6050_setFIFOEnabled(true);
+    MPU6050_resetFIFO();
+
+    stream_head = stream_tail = 0;
+    stream_pending = 0;
+    stream_overflows = 0;
+    stream_running = true;
+    if (xTaskCreate(MPU6050_streamTask, "mpu6050", STREAM_STACK_SIZE, NULL, stream_config.priority, &stream_task) != pdPASS) {
+        stream_running = false;
+        return false;
+    }
+    GPIOInit(stream_config.int_pin, GPIO_INPUT);
+    GPIOActivInt(stream_config.int_pin, MPU6050_streamIsr, true, NULL);
+    return true;
+}
+
+void MPU6050_streamStop() {
+    if (!stream_running) {
+        return;
+    }
+    GPIODeactivInt(stream_config.int_pin);
+    stream_running = false;
+    MPU6050_setIntEnabled(0);
+    MPU6050_setFIFOEnabled(false);
+    I2C_writeByte(devAddr, MPU6050_RA_FIFO_EN, 0);
+}
+
+uint16_t MPU6050_streamRead(mpu6050_sample_t *samples, uint16_t max_qty, uint32_t timeout_ms) {
+    uint16_t qty = 0;
+    uint16_t tail = stream_tail;
+    if (stream_available == NULL) {
+        return 0;
+    }
+    if (tail == stream_head && timeout_ms > 0) {
+        xSemaphoreTake(stream_available, pdMS_TO_TICKS(timeout_ms));
+    }
+    while (qty < max_qty && tail != stream_head) {
+        samples[qty++] = stream_buffer[tail];
+        tail = (tail + 1) & STREAM_MASK;
+    }
+    stream_tail = tail;
+    return qty;
+}
+
+uint32_t MPU6050_streamOverflows() {
+    return stream_overflows;
+}
+
 /*==================[end of file]============================================*/
@@ -0,0 +1,110 @@
+/**
+ * @file qoi.c
+ * @author Eric Beauchamps (beauchampseric97@gmail.com)
+ * @brief Streaming QOI image decoder
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include "qoi.h"
+#include <string.h>
+/*==================[macros and definitions]=================================*/
+#define QOI_OP_INDEX 0x00			/*!< 00xxxxxx: color from index */
+#define QOI_OP_DIFF 0x40			/*!< 01rrggbb: small difference with previous color */
+#define QOI_OP_LUMA 0x80			/*!< 10gggggg rrrrbbbb: difference based on green */
+#define QOI_OP_RUN 0xC0				/*!< 11rrrrrr: previous color repeated */
+#define QOI_OP_RGB 0xFE				/*!< 11111110 r g b: full color */
+#define QOI_OP_RGBA 0xFF			/*!< 11111111 r g b a: full color and alpha */
+#define QOI_MASK 0xC0				/*!< 2 bits op mask */
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/*==================[external functions definition]==========================*/
+bool QoiGetSize(const uint8_t* qoi, uint32_t size, uint32_t* width, uint32_t* height){
+	if ((size < QOI_HEADER_SIZE + QOI_PADDING) || (memcmp(qoi, "qoif", 4) != 0)){
+		return false;
+	}
+	*width = ((uint32_t)qoi[4] << 24) | (qoi[5] << 16) | (qoi[6] << 8) | qoi[7];
+	*height = ((uint32_t)qoi[8] << 24) | (qoi[9] << 16) | (qoi[10] << 8) | qoi[11];
+	return true;
+}
+
+bool QoiDecoderInit(qoi_decoder_t *dec, const uint8_t* qoi, uint32_t size){
+	uint32_t width, height;
+
+	if (!QoiGetSize(qoi, size, &width, &height)){
+		return false;
+	}
+	memset(dec, 0, sizeof(qoi_decoder_t));
+	dec->data = qoi + QOI_HEADER_SIZE;
+	dec->end = qoi + size - QOI_PADDING;
+	dec->px[3] = 255;
+	return true;
+}
+
+void QoiDecode(qoi_decoder_t *dec, uint8_t *dst, uint32_t pixels){
+	uint8_t *px = dec->px;
+	uint8_t op, op2;
+	int8_t dg;
+	uint16_t color;
+
+	while (pixels--){
+		if (dec->run > 0){
+			dec->run--;
+		}
+		else if (dec->data < dec->end){
+			op = *dec->data++;
+			if (op == QOI_OP_RGB){
+				px[0] = dec->data[0];
+				px[1] = dec->data[1];
+				px[2] = dec->data[2];
+				dec->data += 3;
+			}
+			else if (op == QOI_OP_RGBA){
+				px[0] = dec->data[0];
+				px[1] = dec->data[1];
+				px[2] = dec->data[2];
+				px[3] = dec->data[3];
+				dec->data += 4;
+			}
+			else switch (op & QOI_MASK){
+				case QOI_OP_INDEX:
+					memcpy(px, dec->index[op], 4);
+					break;
+				case QOI_OP_DIFF:
+					px[0] += ((op >> 4) & 0x03) - 2;
+					px[1] += ((op >> 2) & 0x03) - 2;
+					px[2] += (op & 0x03) - 2;
+					break;
+				case QOI_OP_LUMA:
+					op2 = *dec->data++;
+					dg = (op & 0x3F) - 32;
+					px[0] += dg - 8 + ((op2 >> 4) & 0x0F);
+					px[1] += dg;
+					px[2] += dg - 8 + (op2 & 0x0F);
+					break;
+				case QOI_OP_RUN:
+					dec->run = op & 0x3F;
+					break;
+			}
+			memcpy(dec->index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+		}
+		/* RGB888 to RGB565 (alpha is ignored) */
+		color = ((px[0] & 0xF8) << 8) | ((px[1] & 0xFC) << 3) | (px[2] >> 3);
+		*dst++ = color >> 8;
+		*dst++ = color & 0xFF;
+	}
+}
+
+/*==================[end of file]============================================*/
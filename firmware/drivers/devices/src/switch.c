@@ -12,18 +12,100 @@
 /*==================[inclusions]=============================================*/
 #include "switch.h"
 #include "gpio_mcu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
 /*==================[macros and definitions]=================================*/
 #define GPIO_SWITCH1 GPIO_4
 #define GPIO_SWITCH2 GPIO_15
+#define SWITCH_QTY	2
 /*==================[internal data declaration]==============================*/
+/**
+ * @brief Debounced state of a switch
+ */
+typedef struct {
+	switch_t sw;				/*!< Switch */
+	bool pressed;				/*!< Debounced state */
+	bool long_sent;				/*!< Long press already notified for this press */
+	bool can_double;			/*!< Last press was short, a new press can be a double click */
+	TickType_t release_time;	/*!< Last release time */
+	TickType_t next_time;		/*!< Next long press or repeat event time */
+} switch_state_t;
 
 /*==================[internal functions declaration]=========================*/
 
 /*==================[internal data definition]===============================*/
+static switch_state_t switches[SWITCH_QTY] = {{.sw = SWITCH_1}, {.sw = SWITCH_2}};
+static QueueHandle_t switch_events = NULL;	/*!< Events for the application */
+static TimerHandle_t switch_timer = NULL;	/*!< Debounce and hold timer */
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Switches edge interrupt: (re)start debounce time
+ */
+static void SwitchEdgeIsr(void *args){
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	xTimerChangePeriodFromISR(switch_timer, pdMS_TO_TICKS(SWITCH_DEBOUNCE_MS), &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+ * @brief Add an event to the queue (events are lost if the application doesn't read them)
+ */
+static void SwitchEventSend(switch_t sw, switch_event_type_t type, TickType_t now){
+	switch_event_t event = {sw, type, now * portTICK_PERIOD_MS};
+	xQueueSend(switch_events, &event, 0);
+}
+
+/**
+ * @brief Timer callback: runs after the switches are stable and while a switch is held
+ */
+static void SwitchTimer(TimerHandle_t timer){
+	TickType_t now = xTaskGetTickCount();
+	TickType_t wait = portMAX_DELAY;
+	int8_t state = SwitchesRead();
+	switch_state_t *s;
+
+	for(uint8_t i = 0; i < SWITCH_QTY; i++){
+		s = &switches[i];
+		if((state & s->sw) && !s->pressed){
+			s->pressed = true;
+			s->long_sent = false;
+			s->next_time = now + pdMS_TO_TICKS(SWITCH_LONG_PRESS_MS);
+			SwitchEventSend(s->sw, SWITCH_PRESS, now);
+			if(s->can_double && (now - s->release_time <= pdMS_TO_TICKS(SWITCH_DOUBLE_CLICK_MS))){
+				SwitchEventSend(s->sw, SWITCH_DOUBLE_CLICK, now);
+				s->can_double = false;
+			} else{
+				s->can_double = true;
+			}
+		} else if(!(state & s->sw) && s->pressed){
+			s->pressed = false;
+			s->release_time = now;
+			if(s->long_sent){
+				s->can_double = false;
+			}
+			SwitchEventSend(s->sw, SWITCH_RELEASE, now);
+		}
+		if(s->pressed){
+			if((int32_t)(now - s->next_time) >= 0){
+				SwitchEventSend(s->sw, s->long_sent ? SWITCH_REPEAT : SWITCH_LONG_PRESS, now);
+				s->long_sent = true;
+				s->next_time = now + pdMS_TO_TICKS(SWITCH_REPEAT_MS);
+			}
+			if(s->next_time - now < wait){
+				wait = s->next_time - now;
+			}
+		}
+	}
+	/* Keep the timer running only while a switch is held */
+	if(wait != portMAX_DELAY){
+		xTimerChangePeriod(timer, (wait > 0) ? wait : 1, 0);
+	}
+}
 
 /*==================[external functions definition]==========================*/
 int8_t SwitchesInit(void){
@@ -54,4 +136,34 @@ void SwitchActivInt(switch_t sw, void *ptr_int_func, void *args){
 		break;
 	}
 }
+
+bool SwitchEventsInit(void){
+	if(switch_events != NULL){
+		return true;
+	}
+	switch_events = xQueueCreate(SWITCH_EVENT_QUEUE_SIZE, sizeof(switch_event_t));
+	switch_timer = xTimerCreate("Switches", pdMS_TO_TICKS(SWITCH_DEBOUNCE_MS), pdFALSE, NULL, SwitchTimer);
+	if((switch_events == NULL) || (switch_timer == NULL)){
+		/* Leave nothing half created, so a later call can retry */
+		if(switch_events != NULL){
+			vQueueDelete(switch_events);
+			switch_events = NULL;
+		}
+		if(switch_timer != NULL){
+			xTimerDelete(switch_timer, 0);
+			switch_timer = NULL;
+		}
+		return false;
+	}
+	GPIOActivIntAnyEdge(GPIO_SWITCH1, SwitchEdgeIsr, NULL);
+	GPIOActivIntAnyEdge(GPIO_SWITCH2, SwitchEdgeIsr, NULL);
+	return true;
+}
+
+bool SwitchEventRead(switch_event_t *event, uint32_t timeout_ms){
+	if(switch_events == NULL){
+		return false;
+	}
+	return xQueueReceive(switch_events, event, (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
 /*==================[end of file]============================================*/
@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""
+@file icon_converter.py
+@brief Generates icons.c with run-length encoded icons for the ILI9341 driver.
+
+The icons are read from an existing icons.c (either the original 1-bpp arrays
+or an already encoded file), optionally replaced by images, and written back
+encoded. Icon names are taken from the icon_t enum of icons.h.
+
+Encoding (pixels of every icon in row order, 1 = foreground):
+    0bbbbbbb  literal: next 7 pixels, first pixel in bit 6
+    1cnnnnnn  run of 8 + n pixels of color c (n < 63)
+    1c111111 m  run of 71 + m pixels of color c
+
+Usage:
+    python icon_converter.py                        # re-encode ../src/icons.c
+    python icon_converter.py --replace 30:ICON_HEART=heart.png
+    python icon_converter.py --preview 22:ICON_WIFI_3
+
+Images need Pillow: they are scaled to the icon size and dark pixels become
+foreground.
+"""
+import argparse
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_SRC = os.path.join(HERE, '..', 'src', 'icons.c')
+DEFAULT_INC = os.path.join(HERE, '..', 'inc', 'icons.h')
+
+RUN_MIN = 8         # shorter runs are stored as literals
+RUN_SHORT = 63      # n values below this are short runs
+RUN_MAX = RUN_MIN + RUN_SHORT + 255
+LITERAL_BITS = 7
+
+HEADER = '''/**
+ * @file icons.c
+ * @author Albano Peñalva (albano.penalva@uner.edu.ar)
+ * @brief Icons data (run-length encoded)
+ * @version 0.2
+ * @date 2024-04-04
+ * 
+ * @note Generated by drivers/devices/tools/icon_converter.py, do not edit by hand.
+ * 
+ * @copyright Copyright (c) 2024
+ * 
+ */
+
+/*==================[inclusions]=============================================*/
+#include "icons.h"
+/*==================[macros and definitions]=================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+'''
+
+FOOTER = '''
+/*==================[internal functions definition]==========================*/
+
+/*==================[external functions definition]==========================*/
+
+/*==================[end of file]============================================*/
+'''
+
+
+def read_names(inc_path):
+    """Icon names in enum order."""
+    text = open(inc_path, encoding='utf-8').read()
+    body = re.search(r'typedef enum\s*\{(.*?)\}\s*icon_t;', text, re.S).group(1)
+    body = re.sub(r'/\*.*?\*/', '', body, flags=re.S)
+    return [m.group(1) for m in re.finditer(r'(ICON_\w+)', body)]
+
+
+def c_bytes(text, name):
+    """Bytes of a C array definition."""
+    start = text.index(name + '[]')
+    end = text.index('};', start)
+    body = re.sub(r'//.*', '', text[start:end])
+    body = re.sub(r'/\*.*?\*/', '', body, flags=re.S)
+    return [int(v, 16) for v in re.findall(r'0x([0-9A-Fa-f]{2})', body)]
+
+
+def c_ints(text, name):
+    """Integers of a C array definition."""
+    start = text.index(name + '[]')
+    end = text.index('};', start)
+    body = re.sub(r'/\*.*?\*/', '', text[text.index('{', start) + 1:end], flags=re.S)
+    return [int(v) for v in re.findall(r'\d+', body)]
+
+
+def decode(code, pixels):
+    """RLE bytes to list of bits."""
+    bits = []
+    i = 0
+    while len(bits) < pixels:
+        b = code[i]
+        i += 1
+        if b & 0x80:
+            n = b & 0x3F
+            if n < RUN_SHORT:
+                length = RUN_MIN + n
+            else:
+                length = RUN_MIN + RUN_SHORT + code[i]
+                i += 1
+            bits += [(b >> 6) & 1] * length
+        else:
+            bits += [(b >> (LITERAL_BITS - 1 - k)) & 1 for k in range(LITERAL_BITS)]
+    return bits[:pixels]
+
+
+def encode(bits):
+    """List of bits to RLE bytes."""
+    out = []
+    i = 0
+    while i < len(bits):
+        j = i
+        while j < len(bits) and bits[j] == bits[i] and j - i < RUN_MAX:
+            j += 1
+        length = j - i
+        if length >= RUN_MIN:
+            n = length - RUN_MIN
+            if n < RUN_SHORT:
+                out.append(0x80 | (bits[i] << 6) | n)
+            else:
+                out += [0x80 | (bits[i] << 6) | RUN_SHORT, n - RUN_SHORT]
+            i = j
+        else:
+            chunk = bits[i:i + LITERAL_BITS]
+            chunk += [0] * (LITERAL_BITS - len(chunk))
+            out.append(sum(b << (LITERAL_BITS - 1 - k) for k, b in enumerate(chunk)))
+            i += LITERAL_BITS
+    return out
+
+
+def read_icons(src_path):
+    """Dict size -> list of icons (list of bits), from an original or encoded icons.c."""
+    text = open(src_path, encoding='utf-8').read()
+    sizes = {}
+    for m in re.finditer(r'icon_font_t\s+icon_(\d+)\s*=\s*\{(.*?)\};', text, re.S):
+        size = int(m.group(1))
+        fields = [f.strip() for f in m.group(2).split(',') if f.strip()]
+        height, width = int(fields[0]), int(fields[1])
+        data = c_bytes(text, fields[3])
+        icons = []
+        if fields[2].isdigit():
+            # Original format: 1 bit per pixel, rows padded to bytes
+            offset = int(fields[2])
+            row_bytes = (width + 7) // 8
+            for k in range(len(data) // offset):
+                bits = []
+                for r in range(height):
+                    row = data[k * offset + r * row_bytes:k * offset + (r + 1) * row_bytes]
+                    bits += [(row[j // 8] >> (7 - j % 8)) & 1 for j in range(width)]
+                icons.append(bits)
+        else:
+            index = c_ints(text, fields[2])
+            icons = [decode(data[start:], width * height) for start in index]
+        sizes[size] = (height, width, icons)
+    return sizes
+
+
+def load_image(path, width, height):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit('Pillow is needed to import images (pip install pillow)')
+    img = Image.open(path).convert('L').resize((width, height))
+    return [1 if img.getpixel((x, y)) < 128 else 0 for y in range(height) for x in range(width)]
+
+
+def write_icons(path, sizes, names):
+    out = [HEADER]
+    for size in sorted(sizes):
+        height, width, icons = sizes[size]
+        index = []
+        data = []
+        start = 0
+        for bits in icons:
+            index.append(start)
+            data.append(encode(bits))
+            start += len(data[-1])
+        out.append('/**\n * @brief {0}x{0} icons start in data array. \n */\n'.format(size))
+        out.append('const uint32_t icon{}_index[] = {{\n'.format(size))
+        for k in range(0, len(index), 8):
+            out.append('    ' + ' '.join('{},'.format(v) for v in index[k:k + 8]) + '\n')
+        out.append('};\n\n')
+        out.append('/**\n * @brief {0}x{0} icons data array (run-length encoded). \n */\n'.format(size))
+        out.append('const uint8_t icon{}_data[] = {{\n'.format(size))
+        for k, code in enumerate(data):
+            out.append('    /* {} */\n'.format(names[k] if k < len(names) else k))
+            for j in range(0, len(code), 16):
+                out.append('    ' + ' '.join('0x{:02X},'.format(v) for v in code[j:j + 16]) + '\n')
+        out.append('};\n\n')
+    out.append('/*==================[external data definition]===============================*/\n')
+    for size in sorted(sizes):
+        height, width, icons = sizes[size]
+        out.append('\nicon_font_t icon_{0} = {{\n    {1},\n    {2},\n    icon{0}_index,\n    icon{0}_data\n}};\n'
+                   .format(size, height, width))
+    out.append(FOOTER)
+    with open(path, 'w', encoding='utf-8', newline='\n') as f:
+        f.write(''.join(out))
+
+
+def parse_target(arg, sizes, names):
+    size, name = arg.split(':', 1)
+    size = int(size)
+    if size not in sizes:
+        sys.exit('Unknown icon size {}'.format(size))
+    if name not in names:
+        sys.exit('Unknown icon {} (add it to icon_t in icons.h first)'.format(name))
+    return size, names.index(name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-i', '--input', default=DEFAULT_SRC, help='icons.c to read (original or encoded)')
+    parser.add_argument('-o', '--output', help='icons.c to write (default: input)')
+    parser.add_argument('--header', default=DEFAULT_INC, help='icons.h with the icon_t enum')
+    parser.add_argument('--replace', action='append', default=[], metavar='SIZE:ICON=IMAGE',
+                        help='replace (or append, if it is the next one of icon_t) an icon with an image')
+    parser.add_argument('--preview', metavar='SIZE:ICON', help='print an icon and exit')
+    args = parser.parse_args()
+
+    names = read_names(args.header)
+    sizes = read_icons(args.input)
+
+    if args.preview:
+        size, k = parse_target(args.preview, sizes, names)
+        height, width, icons = sizes[size]
+        for r in range(height):
+            print(''.join('#' if b else '.' for b in icons[k][r * width:(r + 1) * width]))
+        return
+
+    for item in args.replace:
+        target, image = item.split('=', 1)
+        size, k = parse_target(target, sizes, names)
+        height, width, icons = sizes[size]
+        bits = load_image(image, width, height)
+        if k < len(icons):
+            icons[k] = bits
+        elif k == len(icons):
+            icons.append(bits)
+        else:
+            sys.exit('Icons must be appended in icon_t order')
+
+    for size in sizes:
+        height, width, icons = sizes[size]
+        for bits in icons:
+            assert decode(encode(bits), width * height) == bits
+    write_icons(args.output or args.input, sizes, names)
+    for size in sorted(sizes):
+        height, width, icons = sizes[size]
+        raw = len(icons) * height * ((width + 7) // 8)
+        enc = sum(len(encode(bits)) for bits in icons)
+        print('icon_{}: {} icons, {} -> {} bytes'.format(size, len(icons), raw, enc))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""
+@file image_converter.py
+@brief Converts images to QOI compressed C arrays for ILI9341DrawQoi.
+
+Colors are reduced to RGB565 (what the LCD shows) before encoding, so the
+image drawn on the LCD is exactly the converted one. The decoder of the
+driver is mirrored here: --check decodes every generated image and compares
+it with the source pixels.
+
+Inputs:
+    image.png / .jpg / .bmp ...   needs Pillow (pip install pillow)
+    image.ppm                     binary PPM (P6), no dependencies
+    picture.c                     RGB565 array used with ILI9341DrawPicture
+                                  (--width and --height are needed)
+
+Usage:
+    python image_converter.py logo.png -o ../../../projects/app/main
+    python image_converter.py splash.c --width 240 --height 320 --name splash --check
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+QOI_OP_INDEX = 0x00
+QOI_OP_DIFF = 0x40
+QOI_OP_LUMA = 0x80
+QOI_OP_RUN = 0xC0
+QOI_OP_RGB = 0xFE
+QOI_OP_RGBA = 0xFF
+QOI_PADDING = bytes([0, 0, 0, 0, 0, 0, 0, 1])
+MAX_SIZE = 320
+
+
+def rgb565_to_rgb(color):
+    """RGB565 to RGB888 replicating high bits (exact round trip)."""
+    r = (color >> 11) & 0x1F
+    g = (color >> 5) & 0x3F
+    b = color & 0x1F
+    return ((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))
+
+
+def rgb_to_rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def load_ppm(path):
+    data = open(path, 'rb').read()
+    fields = re.match(rb'P6\s+(?:#.*\s+)*(\d+)\s+(\d+)\s+(\d+)\s', data)
+    if fields is None:
+        sys.exit('{}: only binary PPM (P6) is supported'.format(path))
+    width, height, maxval = (int(v) for v in fields.groups())
+    raw = data[fields.end():fields.end() + width * height * 3]
+    pixels = [tuple(v * 255 // maxval for v in raw[i:i + 3]) for i in range(0, len(raw), 3)]
+    return width, height, pixels
+
+
+def load_pillow(path):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit('Pillow is needed to read {} (pip install pillow), or use a PPM file'.format(path))
+    img = Image.open(path).convert('RGB')
+    return img.width, img.height, list(img.getdata())
+
+
+def load_c_array(path, width, height):
+    if not width or not height:
+        sys.exit('--width and --height are needed for C arrays')
+    text = re.sub(r'//.*|/\*.*?\*/', '', open(path, encoding='utf-8', errors='ignore').read(), flags=re.S)
+    data = [int(v, 16) for v in re.findall(r'0x([0-9A-Fa-f]{1,2})\b', text)]
+    if len(data) < width * height * 2:
+        sys.exit('{}: {} bytes, {} expected'.format(path, len(data), width * height * 2))
+    return width, height, [rgb565_to_rgb((data[2 * i] << 8) | data[2 * i + 1]) for i in range(width * height)]
+
+
+def qoi_hash(r, g, b, a):
+    return (r * 3 + g * 5 + b * 7 + a * 11) % 64
+
+
+def encode(width, height, pixels):
+    """QOI encoder (RGB, 3 channels)."""
+    out = bytearray(b'qoif' + struct.pack('>IIBB', width, height, 3, 0))
+    index = [(0, 0, 0, 0)] * 64
+    prev = (0, 0, 0, 255)
+    run = 0
+    for i, (r, g, b) in enumerate(pixels):
+        px = (r, g, b, 255)
+        if px == prev:
+            run += 1
+            if run == 62 or i == len(pixels) - 1:
+                out.append(QOI_OP_RUN | (run - 1))
+                run = 0
+            continue
+        if run > 0:
+            out.append(QOI_OP_RUN | (run - 1))
+            run = 0
+        h = qoi_hash(*px)
+        if index[h] == px:
+            out.append(QOI_OP_INDEX | h)
+        else:
+            index[h] = px
+            dr = (r - prev[0] + 128) % 256 - 128
+            dg = (g - prev[1] + 128) % 256 - 128
+            db = (b - prev[2] + 128) % 256 - 128
+            dr_dg = dr - dg
+            db_dg = db - dg
+            if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                out.append(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2))
+            elif -32 <= dg <= 31 and -8 <= dr_dg <= 7 and -8 <= db_dg <= 7:
+                out += bytes([QOI_OP_LUMA | (dg + 32), ((dr_dg + 8) << 4) | (db_dg + 8)])
+            else:
+                out += bytes([QOI_OP_RGB, r, g, b])
+        prev = px
+    out += QOI_PADDING
+    return bytes(out)
+
+
+def decode(qoi):
+    """QOI decoder, same as the driver: RGB565 pixels."""
+    width, height = struct.unpack('>II', qoi[4:12])
+    end = len(qoi) - len(QOI_PADDING)
+    index = [[0, 0, 0, 0] for _ in range(64)]
+    px = [0, 0, 0, 255]
+    run = 0
+    p = 14
+    out = []
+    for _ in range(width * height):
+        if run > 0:
+            run -= 1
+        elif p < end:
+            op = qoi[p]
+            p += 1
+            if op == QOI_OP_RGB:
+                px[0:3] = qoi[p:p + 3]
+                p += 3
+            elif op == QOI_OP_RGBA:
+                px[0:4] = qoi[p:p + 4]
+                p += 4
+            elif op & 0xC0 == QOI_OP_INDEX:
+                px = list(index[op])
+            elif op & 0xC0 == QOI_OP_DIFF:
+                px[0] = (px[0] + ((op >> 4) & 3) - 2) % 256
+                px[1] = (px[1] + ((op >> 2) & 3) - 2) % 256
+                px[2] = (px[2] + (op & 3) - 2) % 256
+            elif op & 0xC0 == QOI_OP_LUMA:
+                op2 = qoi[p]
+                p += 1
+                dg = (op & 0x3F) - 32
+                px[0] = (px[0] + dg - 8 + (op2 >> 4)) % 256
+                px[1] = (px[1] + dg) % 256
+                px[2] = (px[2] + dg - 8 + (op2 & 0x0F)) % 256
+            else:
+                run = op & 0x3F
+            index[qoi_hash(*px)] = list(px)
+        out.append(rgb_to_rgb565(*px[0:3]))
+    return width, height, out
+
+
+def write_c(out_dir, name, qoi, width, height, source):
+    lines = ['/**\n * @brief {}x{} QOI image ({} bytes), converted from {}\n */\n'
+             .format(width, height, len(qoi), os.path.basename(source)),
+             'const uint8_t {}[] = {{\n'.format(name)]
+    for i in range(0, len(qoi), 16):
+        lines.append('    ' + ' '.join('0x{:02X},'.format(v) for v in qoi[i:i + 16]) + '\n')
+    lines.append('};\n')
+    with open(os.path.join(out_dir, name + '.c'), 'w', encoding='utf-8', newline='\n') as f:
+        f.write('/*==================[inclusions]=============================================*/\n')
+        f.write('#include <stdint.h>\n')
+        f.write('/*==================[external data definition]===============================*/\n')
+        f.write(''.join(lines))
+        f.write('\n/*==================[end of file]============================================*/\n')
+    guard = name.upper() + '_H_'
+    with open(os.path.join(out_dir, name + '.h'), 'w', encoding='utf-8', newline='\n') as f:
+        f.write('#ifndef {0}\n#define {0}\n'.format(guard))
+        f.write('/*==================[inclusions]=============================================*/\n')
+        f.write('#include <stdint.h>\n')
+        f.write('/*==================[macros]=================================================*/\n')
+        f.write('#define {}_WIDTH\t{}\t\t/*!< Image width in pixels */\n'.format(name.upper(), width))
+        f.write('#define {}_HEIGHT\t{}\t\t/*!< Image height in pixels */\n'.format(name.upper(), height))
+        f.write('#define {}_SIZE\t{}\t/*!< Image size in bytes (for ILI9341DrawQoi) */\n'.format(name.upper(), len(qoi)))
+        f.write('/*==================[external data declaration]==============================*/\n')
+        f.write('extern const uint8_t {}[];\n'.format(name))
+        f.write('#endif /* {} */\n\n'.format(guard))
+        f.write('/*==================[end of file]============================================*/\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('images', nargs='+', help='images to convert')
+    parser.add_argument('-o', '--output', default='.', help='directory for the generated .c/.h files')
+    parser.add_argument('--name', help='array name (default: file name + _qoi, single image only)')
+    parser.add_argument('--width', type=int, help='width of C array images')
+    parser.add_argument('--height', type=int, help='height of C array images')
+    parser.add_argument('--check', action='store_true', help='decode the output and compare with the source')
+    args = parser.parse_args()
+
+    if args.name and len(args.images) > 1:
+        sys.exit('--name can only be used with a single image')
+    failed = False
+    for path in args.images:
+        ext = os.path.splitext(path)[1].lower()
+        if ext == '.c':
+            width, height, pixels = load_c_array(path, args.width, args.height)
+        elif ext == '.ppm':
+            width, height, pixels = load_ppm(path)
+        else:
+            width, height, pixels = load_pillow(path)
+        if width > MAX_SIZE or height > MAX_SIZE:
+            sys.exit('{}: {}x{} is bigger than the LCD'.format(path, width, height))
+        # Reduce to the colors the LCD can show, so the encoding is lossless for it
+        source = [rgb_to_rgb565(*px) for px in pixels]
+        qoi = encode(width, height, [rgb565_to_rgb(c) for c in source])
+        name = args.name or re.sub(r'\W', '_', os.path.splitext(os.path.basename(path))[0]) + '_qoi'
+        write_c(args.output, name, qoi, width, height, path)
+        print('{}: {}x{}, {} -> {} bytes'.format(name, width, height, width * height * 2, len(qoi)))
+        if args.check:
+            w, h, decoded = decode(qoi)
+            ok = (w, h) == (width, height) and decoded == source
+            failed |= not ok
+            print('  check: {}'.format('decoded image matches source' if ok else 'MISMATCH'))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -8,6 +8,12 @@
  ** @{ */
 
 /** \brief GPIO driver to use gpio ouputs with faster functions than gpio_mcu.
+ * 
+ * Pins are grouped in dedicated GPIO bundles (up to GPIO_FAST_BUNDLE_QTY), that can be
+ * written and read with a single CPU instruction.
+ * 
+ * @note ESP32-C6 have 8 dedicated output channels and 8 dedicated input channels,
+ * shared by all the bundles.
  * 
  * @author Albano Peñalva
  *
@@ -16,6 +22,7 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 20/11/2023 | Document creation		                         						|
+ * | 19/10/2026 | Several bundles, input bundles and masked writes						|
  * 
  **/
 
@@ -26,26 +33,80 @@
 /*==================[macros]=================================================*/
 
 /*==================[typedef]================================================*/
+/**
+ * @brief Dedicated GPIO bundles
+ */
+typedef enum {
+	GPIO_FAST_BUNDLE_A = 0,		/**< Bundle used by GPIOFastInit() and GPIOFastWrite() */
+	GPIO_FAST_BUNDLE_B,
+	GPIO_FAST_BUNDLE_C,
+	GPIO_FAST_BUNDLE_D,
+	GPIO_FAST_BUNDLE_QTY
+} gpio_fast_bundle_t;
+
+/**
+ * @brief Dedicated GPIO bundle direction
+ */
+typedef enum {
+	GPIO_FAST_OUTPUT = 0,		/**< Output only bundle */
+	GPIO_FAST_INPUT,			/**< Input only bundle */
+	GPIO_FAST_INPUT_OUTPUT		/**< Bundle that can be written and read back */
+} gpio_fast_dir_t;
 
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
 
 /**
- * @brief 
+ * @brief Initialize GPIO_FAST_BUNDLE_A as an output bundle
  * 
- * @param pin_list 
- * @param pin_qty 
+ * @param pin_list Pins of the bundle (bit i of values corresponds to pin_list[i])
+ * @param pin_qty Number of pins
  */
 void GPIOFastInit(gpio_t *pin_list, uint8_t pin_qty);
 
 /**
- * @brief 
+ * @brief Write all the pins of GPIO_FAST_BUNDLE_A
  * 
- * @param value 
+ * @param value Pins state (bit i: state of pin_list[i])
  */
 void GPIOFastWrite(uint16_t value);
 
+/**
+ * @brief Initialize a dedicated GPIO bundle
+ * 
+ * @param bundle Bundle to initialize
+ * @param pin_list Pins of the bundle (bit i of values corresponds to pin_list[i])
+ * @param pin_qty Number of pins (up to 8)
+ * @param dir Bundle direction
+ * @return true if the bundle could be created
+ */
+bool GPIOFastBundleInit(gpio_fast_bundle_t bundle, gpio_t *pin_list, uint8_t pin_qty, gpio_fast_dir_t dir);
+
+/**
+ * @brief Write some pins of an output bundle (the rest keep their state)
+ * 
+ * @param bundle Output bundle (nothing is written to an input only bundle)
+ * @param mask Pins to write (bit i: pin_list[i])
+ * @param value Pins state (bit i: state of pin_list[i])
+ */
+void GPIOFastBundleWrite(gpio_fast_bundle_t bundle, uint32_t mask, uint32_t value);
+
+/**
+ * @brief Read all the pins of an input bundle
+ * 
+ * @param bundle Input bundle
+ * @return Pins state (bit i: state of pin_list[i]), 0 for an output only bundle
+ */
+uint32_t GPIOFastBundleRead(gpio_fast_bundle_t bundle);
+
+/**
+ * @brief Release a bundle (its dedicated channels can be used by other bundles)
+ * 
+ * @param bundle Bundle to release
+ */
+void GPIOFastBundleDeinit(gpio_fast_bundle_t bundle);
+
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
 /** @} doxygen end group definition */
@@ -26,6 +26,11 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 23/10/2023 | Document creation		                         						|
+ * | 19/10/2026 | Multi-pin masked writes and reads (GPIOWriteMask, GPIOReadMask)		|
+ * | 19/10/2026 | Timestamped edge capture (GPIOEdgeCaptureAdd, GPIOEdgeRead)			|
+ * | 19/10/2026 | Interruption on both edges (GPIOActivIntAnyEdge)						|
+ * | 19/10/2026 | Interruption disable (GPIODeactivInt)									|
+ * | 19/10/2026 | Light sleep wake up source (GPIOWakeUpEnable, GPIOWakeUpDisable)		|
  * 
  **/
 
@@ -33,6 +38,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 /*==================[macros]=================================================*/
+#define GPIO_MASK_MAX_PINS	8	/**< Maximum number of pins in a pin group */
+#define GPIO_EDGE_BUFFER_SIZE	64	/**< Captured edges buffer size (power of 2) */
 
 /*==================[typedef]================================================*/
 /**
@@ -75,6 +82,27 @@ typedef enum gpio_list{
 	GPIO_23, 	/**< GPIO23 */
 } gpio_t;
 
+/**
+ * @brief Group of GPIOs written or read together (precompiled by GPIOMaskInit)
+ * 
+ */
+typedef struct {
+	uint32_t mask;						/**< GPIOs of the group (bit n = GPIO_n) */
+	int8_t shift;						/**< Shift of value when pins are consecutive (-1: not consecutive) */
+	uint8_t qty;						/**< Number of pins */
+	gpio_t pins[GPIO_MASK_MAX_PINS];	/**< Pins (bit i of values corresponds to pins[i]) */
+} gpio_mask_t;
+
+/**
+ * @brief Captured GPIO edge
+ * 
+ */
+typedef struct {
+	int64_t time_us;		/**< Edge time (µs since boot) */
+	uint8_t pin;			/**< GPIO number */
+	bool level;				/**< GPIO level after the edge */
+} gpio_edge_event_t;
+
 /*==================[internal data declaration]==============================*/
 
 /*==================[internal functions declaration]=========================*/
@@ -124,6 +152,36 @@ void GPIOToggle(gpio_t pin);
  */
 bool GPIORead(gpio_t pin);
 
+/**
+ * @brief Build a pin group to be used with GPIOWriteMask() and GPIOReadMask()
+ * 
+ * @note Pins must be initialized with GPIOInit()
+ * 
+ * @param mask Pin group to build
+ * @param pins Pins of the group (bit i of values corresponds to pins[i])
+ * @param qty Number of pins (up to GPIO_MASK_MAX_PINS)
+ * @return true if the group is valid
+ */
+bool GPIOMaskInit(gpio_mask_t *mask, const gpio_t *pins, uint8_t qty);
+
+/**
+ * @brief Change the state of all the pins of a group at the same time
+ * 
+ * All the outputs change in a single register write, so there are no intermediate values.
+ * 
+ * @param mask Pin group
+ * @param value Pins state (bit i: state of pins[i])
+ */
+void GPIOWriteMask(const gpio_mask_t *mask, uint32_t value);
+
+/**
+ * @brief Reads the state of all the pins of a group at the same time
+ * 
+ * @param mask Pin group
+ * @return Pins state (bit i: state of pins[i])
+ */
+uint32_t GPIOReadMask(const gpio_mask_t *mask);
+
 /**
  * @brief Configure GPIO input interruption
  * 
@@ -134,6 +192,81 @@ bool GPIORead(gpio_t pin);
  */
 void GPIOActivInt(gpio_t pin, void *ptr_int_func, bool edge, void *args);
 
+/**
+ * @brief Configure GPIO input interruption on both edges
+ * 
+ * @param pin GPIO number
+ * @param ptr_int_func Pointer to callback function
+ * @param args Pointer to callback function parameters
+ */
+void GPIOActivIntAnyEdge(gpio_t pin, void *ptr_int_func, void *args);
+
+/**
+ * @brief Disable GPIO input interruption and remove its callback function
+ * 
+ * @param pin GPIO number
+ */
+void GPIODeactivInt(gpio_t pin);
+
+/**
+ * @brief Use a GPIO input level to wake up from light sleep
+ * 
+ * @note The pin interruption becomes level triggered: call GPIOWakeUpDisable() after 
+ * waking up to go back to the edge interruption.
+ * 
+ * @param pin GPIO number
+ * @param level Level that wakes up the MCU (true: high - false: low)
+ */
+void GPIOWakeUpEnable(gpio_t pin, bool level);
+
+/**
+ * @brief Stop using a GPIO to wake up from light sleep
+ * 
+ * The interruption type set before GPIOWakeUpEnable() is restored.
+ * 
+ * @param pin GPIO number
+ */
+void GPIOWakeUpDisable(gpio_t pin);
+
+/**
+ * @brief Capture the edges of a GPIO input
+ * 
+ * Every edge (rising and falling) is stored with its time in a buffer shared by all the
+ * captured pins. The interrupt only stores the edge, events are read in batches with
+ * GPIOEdgeRead().
+ * 
+ * @note Pin must be initialized as input with GPIOInit()
+ * 
+ * @param pin GPIO number
+ */
+void GPIOEdgeCaptureAdd(gpio_t pin);
+
+/**
+ * @brief Stop capturing the edges of a GPIO input
+ * 
+ * @param pin GPIO number
+ */
+void GPIOEdgeCaptureRemove(gpio_t pin);
+
+/**
+ * @brief Read captured edges (oldest first)
+ * 
+ * @note Only one task can read the captured edges
+ * 
+ * @param events Array to store the edges
+ * @param max_qty Size of events array
+ * @param timeout_ms Maximum time to wait for the first edge (0: don't wait)
+ * @return Number of edges read
+ */
+uint16_t GPIOEdgeRead(gpio_edge_event_t *events, uint16_t max_qty, uint32_t timeout_ms);
+
+/**
+ * @brief Number of edges lost because the buffer was full
+ * 
+ * @return Lost edges since start
+ */
+uint32_t GPIOEdgeOverflows(void);
+
 /**
  * @brief Configure an input glitch filter to a GPIO
  * 
@@ -21,6 +21,10 @@
  * |   Date	    | Description                                    |
  * |:----------:|:-----------------------------------------------|
  * | 30/01/2024 | Document creation		                         |
+ * | 19/10/2026 | Register reads with repeated start and multi-device reads |
+ * | 19/10/2026 | Optional shadow register cache                 |
+ * | 19/10/2026 | Bus manager task with queued jobs and statistics |
+ * | 19/10/2026 | Device registry (clock and timeout per device) and bus scan |
  *
  */
 
@@ -29,6 +33,9 @@
 #include <stdbool.h>
 #include "esp_log.h"
 #include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "gpio_mcu.h"
 /*==================[macros]=================================================*/
 
@@ -40,6 +47,85 @@
 #define I2C_MASTER_TX_BUF_DISABLE   0           /*!< I2C master doesn't need buffer */
 #define I2C_MASTER_RX_BUF_DISABLE   0           /*!< I2C master doesn't need buffer */
 #define I2C_MASTER_TIMEOUT_MS       1000
+#define I2C_CACHE_DEV_QTY           2           /*!< Number of devices that can use a shadow register cache */
+#define I2C_CACHE_REG_QTY           128         /*!< Registers kept in each cache (addresses 0 to I2C_CACHE_REG_QTY-1) */
+#define I2C_JOB_QUEUE_SIZE          8           /*!< Pending jobs per priority level */
+#define I2C_STATS_DEV_QTY           8           /*!< Number of devices with statistics */
+#define I2C_DEVICE_QTY              8           /*!< Number of devices that can be registered */
+
+/**
+ * @brief Register read to perform with I2C_readBytesMulti()
+ */
+typedef struct {
+	uint8_t devAddr;		/*!< I2C slave device address */
+	uint8_t regAddr;		/*!< First register address to read from */
+	uint8_t length;			/*!< Number of bytes to read */
+	uint8_t *data;			/*!< Buffer to store read data in */
+} i2c_read_t;
+
+/**
+ * @brief Registered device
+ */
+typedef struct {
+	bool registered;			/*!< Entry in use */
+	bool present;				/*!< Device answered the last probe */
+	uint8_t devAddr;			/*!< I2C slave device address */
+	uint32_t clk_speed;			/*!< Maximum SCL frequency of the device (Hz) */
+	uint16_t timeout_ms;		/*!< Transaction timeout (0 = I2C_MASTER_TIMEOUT_MS) */
+} i2c_device_t;
+
+/**
+ * @brief Bus manager job type
+ */
+typedef enum {
+	I2C_JOB_READ,			/*!< Read registers */
+	I2C_JOB_WRITE,			/*!< Write registers */
+} i2c_job_type_t;
+
+/**
+ * @brief Bus manager job priority
+ */
+typedef enum {
+	I2C_JOB_PRIORITY_HIGH,	/*!< Run before any other pending job */
+	I2C_JOB_PRIORITY_NORMAL,
+	I2C_JOB_PRIORITY_LOW,
+	I2C_JOB_PRIORITY_QTY
+} i2c_job_priority_t;
+
+/**
+ * @brief Bus manager job. Must remain valid until it is done.
+ */
+typedef struct {
+	i2c_job_type_t type;		/*!< Read or write */
+	uint8_t devAddr;			/*!< I2C slave device address */
+	uint8_t regAddr;			/*!< First register address */
+	uint8_t length;				/*!< Number of bytes to transfer */
+	uint8_t *data;				/*!< Data to write or buffer to store read data in */
+	i2c_job_priority_t priority;	/*!< Job priority */
+	uint32_t deadline_ms;		/*!< Time since submit to complete the job (0 = I2C_MASTER_TIMEOUT_MS per transaction) */
+	void (*func_p)(void *);		/*!< Function called (from bus manager task) when the job is done */
+	void *param_p;				/*!< Parameter of func_p */
+	volatile esp_err_t result;	/*!< Job result (ESP_ERR_TIMEOUT if the deadline is missed) */
+	volatile bool done;			/*!< Job finished (use I2C_jobWait() before reusing or releasing the job) */
+	int64_t submit_us;			/*!< Submit time (used by the driver) */
+	int64_t expiry_us;			/*!< Deadline time (used by the driver) */
+	SemaphoreHandle_t done_sem;	/*!< Given when the job is done (used by the driver) */
+	StaticSemaphore_t done_sem_buffer;	/*!< Memory of done_sem (used by the driver) */
+} i2c_job_t;
+
+/**
+ * @brief Bus manager statistics of a device
+ */
+typedef struct {
+	bool used;					/*!< Entry in use */
+	uint8_t devAddr;			/*!< I2C slave device address */
+	uint32_t jobs;				/*!< Jobs completed */
+	uint32_t errors;			/*!< Jobs failed (NACK, bus error) */
+	uint32_t timeouts;			/*!< Jobs that missed their deadline */
+	uint32_t last_latency_us;	/*!< Submit to completion time of the last job */
+	uint32_t max_latency_us;	/*!< Maximum submit to completion time */
+	uint64_t total_latency_us;	/*!< Sum of latencies (average = total_latency_us / jobs) */
+} i2c_stats_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -100,15 +186,25 @@ int8_t I2C_readWord(uint8_t devAddr, uint8_t regAddr, uint16_t *data, uint16_t t
 
 /** @fn I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout)
  * @brief Read multiple bytes from an 8-bit device register.
+ * @note Register address and data are transferred in a single transaction with a repeated start.
  * @param devAddr I2C slave device address
  * @param regAddr First register regAddr to read from
  * @param length Number of bytes to read
  * @param data Buffer to store read data in
- * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return I2C_TransferReturn_TypeDef
+ * @param timeout Optional read timeout in milliseconds (0 to use I2C_MASTER_TIMEOUT_MS)
+ * @return Number of bytes read (0 = error)
  */
 int8_t I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout);
 
+/** @fn I2C_readBytesMulti(i2c_read_t *reads, uint8_t qty, uint16_t timeout)
+ * @brief Read registers of several devices (or several register blocks) in one bus transaction.
+ * @param reads Array of reads to perform
+ * @param qty Number of reads
+ * @param timeout Optional read timeout in milliseconds (0 to use the longest registered timeout of the devices involved, or I2C_MASTER_TIMEOUT_MS)
+ * @return true if all the reads were performed, false on error
+ */
+bool I2C_readBytesMulti(i2c_read_t *reads, uint8_t qty, uint16_t timeout);
+
 /** @fn I2C_writeBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t data);
  * @brief write a single bit in an 8-bit device register.
  * @param devAddr I2C slave device address
@@ -158,6 +254,151 @@ bool I2C_writeWord(uint8_t devAddr, uint8_t regAddr, uint16_t data);
  */
 bool I2C_writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data);
 
+/** @fn I2C_cacheEnable(uint8_t devAddr)
+ * @brief Enable the shadow register cache of a device.
+ * 
+ * Register values read from or written to the device are kept in RAM, so later reads
+ * (and the read part of I2C_writeBit()/I2C_writeBits()) don't need a bus transaction.
+ * Registers changed by the device itself (status, data, self-clearing bits, etc.) must be
+ * declared with I2C_cacheVolatile().
+ * @param devAddr I2C slave device address
+ * @return true if the cache could be assigned to the device
+ */
+bool I2C_cacheEnable(uint8_t devAddr);
+
+/** @fn I2C_cacheDisable(uint8_t devAddr)
+ * @brief Commit pending writes and disable the shadow register cache of a device.
+ * @param devAddr I2C slave device address
+ */
+void I2C_cacheDisable(uint8_t devAddr);
+
+/** @fn I2C_cacheVolatile(uint8_t devAddr, uint8_t regAddr, uint8_t length)
+ * @brief Declare registers that must always be accessed on the bus.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address
+ * @param length Number of registers
+ */
+void I2C_cacheVolatile(uint8_t devAddr, uint8_t regAddr, uint8_t length);
+
+/** @fn I2C_cacheLoad(uint8_t devAddr, uint8_t regAddr, uint8_t length)
+ * @brief Fill the cache with the current device values of a range of registers.
+ * 
+ * Values already in the cache are refreshed (pending deferred writes are kept). 
+ * Only cacheable registers are read, consecutive ones in a single transaction. Volatile
+ * registers are skipped, so reads with side effects (status flags cleared on read, FIFO
+ * ports, etc.) never happen.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address
+ * @param length Number of registers
+ * @return Status of operation (true = success)
+ */
+bool I2C_cacheLoad(uint8_t devAddr, uint8_t regAddr, uint8_t length);
+
+/** @fn I2C_cacheInvalidate(uint8_t devAddr)
+ * @brief Discard all cached values and pending writes (e.g. after a device reset).
+ * 
+ * Pending writes are dropped, not written: call I2C_cacheCommit() first if the device
+ * must receive them.
+ * @param devAddr I2C slave device address
+ */
+void I2C_cacheInvalidate(uint8_t devAddr);
+
+/** @fn I2C_cacheDefer(uint8_t devAddr, bool defer)
+ * @brief Keep writes to cached registers in RAM until I2C_cacheCommit() is called.
+ * @param devAddr I2C slave device address
+ * @param defer true = keep writes, false = write through
+ * @return false if the device has no cache
+ */
+bool I2C_cacheDefer(uint8_t devAddr, bool defer);
+
+/** @fn I2C_cacheCommit(uint8_t devAddr)
+ * @brief Write all pending registers to the device.
+ * 
+ * Registers are written in address order, consecutive registers in a single transaction.
+ * @param devAddr I2C slave device address
+ * @return Status of operation (true = success)
+ */
+bool I2C_cacheCommit(uint8_t devAddr);
+
+/** @fn I2C_deviceRegister(uint8_t devAddr, uint32_t clk_speed, uint16_t timeout_ms)
+ * @brief Register a device with its own bus configuration.
+ * 
+ * The SCL frequency is switched before every transaction with the device, so fast devices
+ * don't have to run at the speed of the slowest one. Not registered devices use the
+ * frequency given to I2C_initialize().
+ * @param devAddr I2C slave device address
+ * @param clk_speed Maximum SCL frequency of the device in Hz (0 = I2C_initialize() frequency)
+ * @param timeout_ms Transaction timeout in milliseconds (0 = I2C_MASTER_TIMEOUT_MS)
+ * @return false if the registry is full
+ */
+bool I2C_deviceRegister(uint8_t devAddr, uint32_t clk_speed, uint16_t timeout_ms);
+
+/** @fn I2C_deviceProbe(uint8_t devAddr)
+ * @brief Check if a device acknowledges its address.
+ * @param devAddr I2C slave device address
+ * @return true if the device is present
+ */
+bool I2C_deviceProbe(uint8_t devAddr);
+
+/** @fn I2C_scan(uint8_t *found, uint8_t max_qty)
+ * @brief Probe all the 7-bit addresses (0x08 to 0x77).
+ * 
+ * Registered devices are marked as present or not (see I2C_devicePresent()).
+ * @param found Array to store the addresses found (can be NULL)
+ * @param max_qty Size of found array
+ * @return Number of devices found
+ */
+uint8_t I2C_scan(uint8_t *found, uint8_t max_qty);
+
+/** @fn I2C_devicePresent(uint8_t devAddr)
+ * @brief Result of the last probe of a registered device.
+ * @param devAddr I2C slave device address
+ * @return true if the device answered
+ */
+bool I2C_devicePresent(uint8_t devAddr);
+
+/** @fn I2C_jobManagerInit(UBaseType_t priority)
+ * @brief Start the bus manager task.
+ * 
+ * The task runs queued jobs back to back, highest priority first. Blocking I2C_* functions
+ * can still be used: all bus accesses are serialized.
+ * @note I2C_initialize() must be called first.
+ * @param priority FreeRTOS priority of the bus manager task
+ * @return Status of operation (true = success)
+ */
+bool I2C_jobManagerInit(UBaseType_t priority);
+
+/** @fn I2C_jobSubmit(i2c_job_t *job)
+ * @brief Queue a job for the bus manager (returns immediately).
+ * @param job Job to run. Must remain valid until done.
+ * @return false if the queue of the job priority is full
+ */
+bool I2C_jobSubmit(i2c_job_t *job);
+
+/** @fn I2C_jobWait(i2c_job_t *job, uint32_t timeout_ms)
+ * @brief Wait for a job to finish.
+ * 
+ * Completion is signaled with a semaphore of the job: task notifications (used by
+ * DelayMs() and others) are not touched.
+ * @param job Submitted job
+ * @param timeout_ms Maximum time to wait (portMAX_DELAY to wait forever)
+ * @return true if the job is done
+ */
+bool I2C_jobWait(i2c_job_t *job, uint32_t timeout_ms);
+
+/** @fn I2C_getStats(uint8_t devAddr, i2c_stats_t *stats)
+ * @brief Get the bus manager statistics of a device.
+ * @param devAddr I2C slave device address
+ * @param stats Statistics copy
+ * @return false if there are no jobs for the device yet
+ */
+bool I2C_getStats(uint8_t devAddr, i2c_stats_t *stats);
+
+/** @fn I2C_resetStats(void)
+ * @brief Clear the bus manager statistics of all devices.
+ */
+void I2C_resetStats(void);
+
 /** @fn I2C_SelectRegister(uint8_t dev, uint8_t reg)
  * @brief Select a register
  * @param devAddr I2C slave device address
@@ -0,0 +1,142 @@
+#ifndef PCNT_MCU_H
+#define PCNT_MCU_H
+
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Drivers_Microcontroller Drivers microcontroller
+ ** @{ */
+/** \addtogroup PCNT PCNT
+ ** @{ */
+
+/** \brief Pulse counter driver for the ESP-EDU Board.
+ * 
+ * Pulses are counted by the PCNT peripheral, without an interruption per edge. It can be
+ * used to count events, to measure frequency (tachometers, flow meters, etc.) and to
+ * decode quadrature encoders.
+ * 
+ * @note The hardware counter is 16 bits wide; the IDF extends it to 32 bits with one
+ * interruption every PCNT_LIMIT counts, and PcntRead() to 64 bits (it must be called at
+ * least once every 2^31 counts).
+ * 
+ * @author Eric Beauchamps
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 19/10/2026 | Document creation		                         						|
+ * 
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio_mcu.h"
+/*==================[macros]=================================================*/
+#define PCNT_LIMIT	30000	/*!< Hardware count limit (counter goes back to 0 when reaching +/-PCNT_LIMIT) */
+
+/*==================[typedef]================================================*/
+/**
+ * @brief List of available pulse counters in this driver
+ */
+typedef enum pcnt_units {
+	PCNT_A,						/*!< Pulse counter A */
+	PCNT_B,						/*!< Pulse counter B */
+	PCNT_C,						/*!< Pulse counter C */
+	PCNT_D						/*!< Pulse counter D */
+} pcnt_mcu_t;
+
+/**
+ * @brief Counting modes
+ */
+typedef enum {
+	PCNT_RISING_EDGE,			/*!< Count rising edges of pin_a */
+	PCNT_FALLING_EDGE,			/*!< Count falling edges of pin_a */
+	PCNT_BOTH_EDGES,			/*!< Count both edges of pin_a */
+	PCNT_QUADRATURE				/*!< Quadrature encoder on pin_a and pin_b (4 counts per cycle) */
+} pcnt_mode_t;
+
+/**
+ * @brief Pulse counter configuration struct
+ */
+typedef struct {
+	pcnt_mcu_t unit;			/*!< Selected pulse counter */
+	gpio_t pin_a;				/*!< Pulses input (encoder channel A in quadrature mode) */
+	gpio_t pin_b;				/*!< Encoder channel B (only quadrature mode) */
+	pcnt_mode_t mode;			/*!< Counting mode */
+	uint32_t glitch_ns;			/*!< Pulses shorter than this are ignored (0: no filter, up to ~1000 ns) */
+} pcnt_mcu_config_t;
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief Pulse counter initialization
+ * 
+ * @note Counter is stopped and in 0 after init
+ * 
+ * @param pcnt_ini Pointer to pulse counter configuration
+ * @return true if the counter could be configured
+ */
+bool PcntInit(pcnt_mcu_config_t *pcnt_ini);
+
+/**
+ * @brief Start counting
+ * 
+ * @param unit Pulse counter
+ */
+void PcntStart(pcnt_mcu_t unit);
+
+/**
+ * @brief Pause counting
+ * 
+ * @param unit Pulse counter
+ */
+void PcntStop(pcnt_mcu_t unit);
+
+/**
+ * @brief Reset count to 0
+ * 
+ * @param unit Pulse counter
+ */
+void PcntReset(pcnt_mcu_t unit);
+
+/**
+ * @brief Read count (64 bits)
+ * 
+ * @param unit Pulse counter
+ * @return Pulses counted since last reset (negative if the encoder moved backwards)
+ */
+int64_t PcntRead(pcnt_mcu_t unit);
+
+/**
+ * @brief Read count (32 bits, wraps around)
+ * 
+ * @param unit Pulse counter
+ * @return Pulses counted since last reset
+ */
+int32_t PcntRead32(pcnt_mcu_t unit);
+
+/**
+ * @brief Measure pulses frequency counting during a gate time
+ * 
+ * @note The calling task is blocked during gate_ms. Counter must be started.
+ * 
+ * @param unit Pulse counter
+ * @param gate_ms Gate time (longer gates give more resolution: 1000 ms -> 1 Hz)
+ * @return Frequency in Hz
+ */
+uint32_t PcntFrequency(pcnt_mcu_t unit, uint32_t gate_ms);
+
+/**
+ * @brief Pulse counter de-initialization
+ * 
+ * @param unit Pulse counter
+ */
+void PcntDeinit(pcnt_mcu_t unit);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif 
+
+/*==================[end of file]============================================*/
@@ -21,12 +21,21 @@
  * |   Date	    | Description                                    						|
  * |:----------:|:----------------------------------------------------------------------|
  * | 09/02/2024 | Document creation		                         						|
+ * | 19/10/2026 | Asynchronous queued transfers		                         			|
+ * | 19/10/2026 | Transfers of any size and DMA buffer pool		                        |
+ * | 19/10/2026 | Data/command pin driven by the driver		                        	|
  * 
  **/
 /*==================[inclusions]=============================================*/
 #include <stdbool.h>
 #include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/spi_master.h"
+#include "gpio_mcu.h"
 /*==================[macros]=================================================*/
+#define SPI_QUEUE_SIZE			8		/*!< Maximum number of transactions in flight per device */
+#define SPI_MAX_CHUNK_SIZE		30720	/*!< Maximum number of bytes of a single DMA transaction (larger transfers are split) */
 
 /*==================[typedef]================================================*/
 
@@ -69,6 +78,33 @@ typedef struct{
 	void *func_p;					/*!< Pointer to callback function for transaction end */
 	void *param_p;					/*!< Pointer to callback parameter */
 } spi_mcu_config_t;
+
+/**
+ * @brief Level of the data/command pin during a transfer (see SpiSetDcPin)
+ */
+typedef enum {
+	SPI_DC_NONE = 0,	/*!< D/C pin is not changed */
+	SPI_DC_COMMAND,		/*!< D/C pin low: command bytes */
+	SPI_DC_DATA,		/*!< D/C pin high: parameters or data bytes */
+} spi_dc_t;
+
+/**
+ * @brief SPI asynchronous transfer descriptor
+ * 
+ * @note The descriptor and its buffers are owned by the caller and must remain 
+ * valid (and unmodified) until the transfer is completed.
+ */
+typedef struct{
+	uint8_t *tx_buffer;				/*!< Pointer to data to write (NULL: read only) */
+	uint8_t *rx_buffer;				/*!< Pointer to buffer where read data is stored (NULL: write only) */
+	uint32_t size;					/*!< Number of bytes to transfer (any size) */
+	spi_dc_t dc;					/*!< Level of the D/C pin while transferring */
+	void *func_p;					/*!< Pointer to callback function for transfer end (called from ISR, may be NULL) */
+	void *param_p;					/*!< Pointer to callback parameter */
+	TaskHandle_t task_to_notify;	/*!< Task to notify (xTaskNotifyGive) on transfer end (may be NULL) */
+	volatile uint32_t pending;		/*!< Number of transactions not yet completed (driver use) */
+	volatile bool done;				/*!< Set by the driver when the transfer is completed */
+} spi_transfer_t;
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -83,6 +119,9 @@ uint8_t SpiInit(spi_mcu_config_t* spi);
 /**
  * @brief Read data from SPI port
  * 
+ * @note Transfers of any size are allowed: data is split in chunks of up to 
+ * SPI_MAX_CHUNK_SIZE bytes, queued back to back.
+ * 
  * @param device SPI device to read from
  * @param rx_buffer pointer to buffer where data is stored
  * @param rx_buffer_size numbers of bytes to read
@@ -92,6 +131,9 @@ void SpiRead(spi_dev_t device, uint8_t * rx_buffer, uint32_t rx_buffer_size);
 /**
  * @brief Write data from SPI port
  * 
+ * @note Transfers of any size are allowed: data is split in chunks of up to 
+ * SPI_MAX_CHUNK_SIZE bytes, queued back to back.
+ * 
  * @param device SPI device to read from
  * @param tx_buffer pointer to buffer where data is stored
  * @param tx_buffer_size numbers of bytes to write
@@ -108,6 +150,94 @@ void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size);
  */
 void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, uint32_t buffer_size);
 
+/**
+ * @brief Queue a transfer on SPI port and return without waiting for it to end
+ * 
+ * Up to SPI_QUEUE_SIZE transactions can be in flight for each device, so the next 
+ * transaction starts as soon as the previous one ends. Transfers larger than 
+ * SPI_MAX_CHUNK_SIZE are split in several transactions. If the queue is full, 
+ * the function waits for the oldest transaction to end. 
+ * 
+ * @note Write only transfers of up to 4 bytes are copied into the transaction, 
+ * so no DMA descriptor is used for commands and short parameters.
+ * 
+ * @note Completion is signaled setting transfer->done, calling transfer->func_p 
+ * (from ISR) and/or notifying transfer->task_to_notify. Results of finished 
+ * transfers are collected with SpiWaitTransfers (or by the next blocking call).
+ * 
+ * @param device SPI device
+ * @param transfer Pointer to transfer descriptor
+ * @return true if the transfer was queued, false otherwise
+ */
+bool SpiQueueTransfer(spi_dev_t device, spi_transfer_t *transfer);
+
+/**
+ * @brief Assign a data/command pin to a SPI device
+ * 
+ * The pin is driven from the SPI driver right before each transaction of a 
+ * queued transfer starts, according to transfer->dc. Command and data transfers 
+ * can then be queued back to back, without waiting between them to toggle the pin.
+ * 
+ * @param device SPI device
+ * @param pin GPIO used as D/C pin (configured as output)
+ */
+void SpiSetDcPin(spi_dev_t device, gpio_t pin);
+
+/**
+ * @brief Wait until all the transfers queued on a SPI device are completed
+ * 
+ * @param device SPI device
+ * @param timeout_ms Maximum time to wait (in ms) for each transfer
+ * @return true if all the transfers were completed, false on timeout
+ */
+bool SpiWaitTransfers(spi_dev_t device, uint32_t timeout_ms);
+
+/**
+ * @brief Create a pool of DMA capable (word aligned) buffers
+ * 
+ * Drivers can render directly into these buffers and send them without 
+ * intermediate copies. The pool is shared by all the SPI devices: if it was 
+ * already created, the call succeeds only if the existing buffers are big enough
+ * (the pool may then have a different number of buffers, see SpiBufferQty).
+ * If any buffer can not be allocated, none is kept and the call fails.
+ * 
+ * @param buffer_qty Number of buffers
+ * @param buffer_size Size of each buffer (in bytes)
+ * @return true if the pool is available
+ */
+bool SpiBufferPoolInit(uint8_t buffer_qty, uint32_t buffer_size);
+
+/**
+ * @brief Take a buffer from the DMA buffer pool
+ * 
+ * @param timeout_ms Maximum time to wait (in ms) for a free buffer
+ * @return uint8_t* Pointer to buffer (NULL if there are no free buffers)
+ */
+uint8_t * SpiBufferGet(uint32_t timeout_ms);
+
+/**
+ * @brief Return a buffer to the DMA buffer pool
+ * 
+ * @note Can be called from a transfer end callback (ISR).
+ * 
+ * @param buffer Pointer to buffer obtained with SpiBufferGet
+ */
+void SpiBufferRelease(uint8_t * buffer);
+
+/**
+ * @brief Get the size of the buffers of the DMA buffer pool
+ * 
+ * @return uint32_t Buffer size in bytes (0 if the pool was not created)
+ */
+uint32_t SpiBufferSize(void);
+
+/**
+ * @brief Get the number of buffers of the DMA buffer pool
+ * 
+ * @return uint8_t Number of buffers (0 if the pool was not created)
+ */
+uint8_t SpiBufferQty(void);
+
 /**
  * @brief De-Initialize SPI module with the corresponding configuration
  * 
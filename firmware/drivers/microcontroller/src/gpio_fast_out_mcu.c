@@ -16,14 +16,24 @@
 #include <string.h>
 #include "driver/gpio.h"
 #include "driver/dedic_gpio.h"
+#include "hal/dedic_gpio_cpu_ll.h"
 /*==================[macros and definitions]=================================*/
-
+#define BUNDLE_MAX_PINS	8	/*!< Dedicated GPIO channels of each direction */
 /*==================[internal data declaration]==============================*/
-dedic_gpio_bundle_handle_t bundleA = NULL;
-int bundleA_gpios[16];
+/**
+ * @brief Dedicated GPIO bundle data
+ */
+typedef struct{
+	dedic_gpio_bundle_handle_t handle;	/*!< IDF bundle handle */
+	uint32_t mask;						/*!< Mask of bundle pins (bit 0: first pin) */
+	uint8_t out_offset;					/*!< First dedicated output channel */
+	uint8_t in_offset;					/*!< First dedicated input channel */
+	gpio_fast_dir_t dir;				/*!< Bundle direction */
+} bundle_data_t;
 /*==================[internal functions declaration]=========================*/
 
 /*==================[internal data definition]===============================*/
+static bundle_data_t bundles[GPIO_FAST_BUNDLE_QTY];
 
 /*==================[external data definition]===============================*/
 
@@ -32,27 +42,83 @@ int bundleA_gpios[16];
 /*==================[external functions definition]==========================*/
 
 void GPIOFastInit(gpio_t *pin_list, uint8_t pin_qty){
-    memcpy(bundleA_gpios, pin_list, pin_qty);
+    GPIOFastBundleInit(GPIO_FAST_BUNDLE_A, pin_list, pin_qty, GPIO_FAST_OUTPUT);
+}
+
+void GPIOFastWrite(uint16_t value){
+    GPIOFastBundleWrite(GPIO_FAST_BUNDLE_A, bundles[GPIO_FAST_BUNDLE_A].mask, value);
+}
+
+bool GPIOFastBundleInit(gpio_fast_bundle_t bundle, gpio_t *pin_list, uint8_t pin_qty, gpio_fast_dir_t dir){
+    bundle_data_t *b = &bundles[bundle];
+    int gpios[BUNDLE_MAX_PINS];
+    uint32_t offset;
     gpio_config_t io_conf = {
-        .mode = GPIO_MODE_OUTPUT,
+        .mode = (dir == GPIO_FAST_OUTPUT) ? GPIO_MODE_OUTPUT :
+                (dir == GPIO_FAST_INPUT) ? GPIO_MODE_INPUT : GPIO_MODE_INPUT_OUTPUT,
     };
+    if ((pin_qty == 0) || (pin_qty > BUNDLE_MAX_PINS)) {
+        return false;
+    }
+    GPIOFastBundleDeinit(bundle);
+    /* gpio_t and int may differ in size: copy each pin */
     for (int i = 0; i < pin_qty; i++) {
-        io_conf.pin_bit_mask = 1ULL << bundleA_gpios[i];
+        gpios[i] = pin_list[i];
+        io_conf.pin_bit_mask = 1ULL << gpios[i];
         gpio_config(&io_conf);
     }
-    // Create bundleA, output only
-    dedic_gpio_bundle_config_t bundleA_config = {
-        .gpio_array = bundleA_gpios,
+    dedic_gpio_bundle_config_t bundle_config = {
+        .gpio_array = gpios,
         .array_size = pin_qty,
         .flags = {
-            .out_en = 1,
+            .out_en = (dir != GPIO_FAST_INPUT),
+            .in_en = (dir != GPIO_FAST_OUTPUT),
         },
     };
-    ESP_ERROR_CHECK(dedic_gpio_new_bundle(&bundleA_config, &bundleA));
+    if (dedic_gpio_new_bundle(&bundle_config, &b->handle) != ESP_OK) {
+        b->handle = NULL;
+        return false;
+    }
+    /* Channels of the bundle in the CPU dedicated GPIO registers */
+    b->mask = (1UL << pin_qty) - 1;
+    b->dir = dir;
+    b->out_offset = 0;
+    b->in_offset = 0;
+    if (dir != GPIO_FAST_INPUT) {
+        dedic_gpio_get_out_offset(b->handle, &offset);
+        b->out_offset = offset;
+    }
+    if (dir != GPIO_FAST_OUTPUT) {
+        dedic_gpio_get_in_offset(b->handle, &offset);
+        b->in_offset = offset;
+    }
+    return true;
 }
 
-void GPIOFastWrite(uint16_t value){
-    dedic_gpio_bundle_write(bundleA, 0xFF, value);
+void GPIOFastBundleWrite(gpio_fast_bundle_t bundle, uint32_t mask, uint32_t value){
+    bundle_data_t *b = &bundles[bundle];
+    /* Input bundles have no output channels: out_offset would point to another bundle's */
+    if ((b->handle == NULL) || (b->dir == GPIO_FAST_INPUT)) {
+        return;
+    }
+    mask &= b->mask;
+    dedic_gpio_cpu_ll_write_mask(mask << b->out_offset, value << b->out_offset);
+}
+
+uint32_t GPIOFastBundleRead(gpio_fast_bundle_t bundle){
+    bundle_data_t *b = &bundles[bundle];
+    if ((b->handle == NULL) || (b->dir == GPIO_FAST_OUTPUT)) {
+        return 0;
+    }
+    return (dedic_gpio_cpu_ll_read_in() >> b->in_offset) & b->mask;
+}
+
+void GPIOFastBundleDeinit(gpio_fast_bundle_t bundle){
+    if (bundles[bundle].handle != NULL) {
+        dedic_gpio_del_bundle(bundles[bundle].handle);
+        bundles[bundle].handle = NULL;
+        bundles[bundle].mask = 0;
+    }
 }
 
 /*==================[end of file]============================================*/
\ No newline at end of file
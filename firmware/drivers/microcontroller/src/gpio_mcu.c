@@ -14,6 +14,12 @@
 #include <stdint.h>
 #include "driver/gpio.h"
 #include "driver/gpio_filter.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "soc/gpio_reg.h"
 /*==================[macros and definitions]=================================*/
 #define GPIO_QTY 	24
 #define FILTER_QTY	8
@@ -22,6 +28,7 @@ typedef struct{
 	gpio_mode_t mode;			/*!< Input/Output mode */
 	gpio_pull_mode_t pull;		/*!< GPIO pull-up/pull-down resistor */
 	bool state;					/*!< GPIO output state */
+	gpio_int_type_t intr_type;	/*!< Input interruption (restored after a wake up) */
 } digital_io_t;
 /*==================[internal data declaration]==============================*/
 
@@ -59,9 +66,50 @@ gpio_flex_glitch_filter_config_t filter_config = {
 	.window_width_ns = 700,
 	.window_thres_ns = 600,
 };
+static portMUX_TYPE gpio_mux = portMUX_INITIALIZER_UNLOCKED;
+static gpio_edge_event_t edge_buffer[GPIO_EDGE_BUFFER_SIZE];	/*!< Captured edges (written by ISR, read by task) */
+static volatile uint16_t edge_head = 0;		/*!< Next position to write (only ISR) */
+static volatile uint16_t edge_tail = 0;		/*!< Next position to read (only reading task) */
+static volatile uint32_t edge_overflows = 0;
+static SemaphoreHandle_t edge_available = NULL;	/*!< Given when the buffer stops being empty */
+static bool isr_service_installed = false;
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Set the interruption type of a GPIO, keeping it to restore it later
+ * 
+ * @param pin GPIO number
+ * @param type Interruption type
+ */
+static void GPIOSetIntrType(gpio_t pin, gpio_int_type_t type){
+	gpio_list[pin].intr_type = type;
+	gpio_set_intr_type(gpio_list[pin].pin, type);
+}
+
+/**
+ * @brief Edge capture interrupt: stores pin, level and time
+ * 
+ * @param args GPIO number
+ */
+static void IRAM_ATTR GPIOEdgeIsr(void *args){
+	uint8_t pin = (uintptr_t)args;
+	uint16_t head = edge_head;
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	if(((head + 1) & (GPIO_EDGE_BUFFER_SIZE - 1)) == edge_tail){
+		edge_overflows++;
+		return;
+	}
+	edge_buffer[head].time_us = esp_timer_get_time();
+	edge_buffer[head].pin = pin;
+	edge_buffer[head].level = (REG_READ(GPIO_IN_REG) >> pin) & 1;
+	edge_head = (head + 1) & (GPIO_EDGE_BUFFER_SIZE - 1);
+	/* Wake the reader only when the buffer was empty */
+	if(head == edge_tail){
+		xSemaphoreGiveFromISR(edge_available, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
 
 /*==================[external functions definition]==========================*/
 void GPIOInit(gpio_t pin, io_t io){
@@ -102,12 +150,106 @@ bool GPIORead(gpio_t pin){
 	return gpio_get_level(gpio_list[pin].pin);
 }
 
+bool GPIOMaskInit(gpio_mask_t *mask, const gpio_t *pins, uint8_t qty){
+	if((qty == 0) || (qty > GPIO_MASK_MAX_PINS)){
+		return false;
+	}
+	mask->mask = 0;
+	mask->qty = qty;
+	mask->shift = pins[0];
+	for(uint8_t i = 0; i < qty; i++){
+		if((pins[i] == GPIO_14) || (pins[i] > GPIO_23)){
+			return false;
+		}
+		mask->pins[i] = pins[i];
+		mask->mask |= 1UL << pins[i];
+		/* Consecutive pins in ascending order: value only needs a shift */
+		if(pins[i] != pins[0] + i){
+			mask->shift = -1;
+		}
+	}
+	return true;
+}
+
+void GPIOWriteMask(const gpio_mask_t *mask, uint32_t value){
+	uint32_t bits = 0;
+	if(mask->shift >= 0){
+		bits = (value << mask->shift) & mask->mask;
+	} else{
+		for(uint8_t i = 0; i < mask->qty; i++){
+			if(value & (1UL << i)){
+				bits |= 1UL << mask->pins[i];
+			}
+		}
+	}
+	/* Single write of the output register: all the pins change at the same time */
+	portENTER_CRITICAL(&gpio_mux);
+	REG_WRITE(GPIO_OUT_REG, (REG_READ(GPIO_OUT_REG) & ~mask->mask) | bits);
+	portEXIT_CRITICAL(&gpio_mux);
+	for(uint8_t i = 0; i < mask->qty; i++){
+		gpio_list[mask->pins[i]].state = (value >> i) & 1;
+	}
+}
+
+uint32_t GPIOReadMask(const gpio_mask_t *mask){
+	uint32_t bits = REG_READ(GPIO_IN_REG) & mask->mask;
+	uint32_t value = 0;
+	if(mask->shift >= 0){
+		return bits >> mask->shift;
+	}
+	for(uint8_t i = 0; i < mask->qty; i++){
+		if(bits & (1UL << mask->pins[i])){
+			value |= 1UL << i;
+		}
+	}
+	return value;
+}
+
+void GPIOEdgeCaptureAdd(gpio_t pin){
+	if(edge_available == NULL){
+		edge_available = xSemaphoreCreateBinary();
+	}
+	GPIOSetIntrType(pin, GPIO_INTR_ANYEDGE);
+	if(!isr_service_installed){	
+		gpio_install_isr_service(0);
+		isr_service_installed = true;
+	}
+	gpio_isr_handler_add(gpio_list[pin].pin, GPIOEdgeIsr, (void *)(uintptr_t)pin);
+}
+
+void GPIOEdgeCaptureRemove(gpio_t pin){
+	GPIOSetIntrType(pin, GPIO_INTR_DISABLE);
+	gpio_isr_handler_remove(gpio_list[pin].pin);
+}
+
+uint16_t GPIOEdgeRead(gpio_edge_event_t *events, uint16_t max_qty, uint32_t timeout_ms){
+	uint16_t qty = 0;
+	uint16_t tail = edge_tail;
+	if(edge_available == NULL){
+		return 0;
+	}
+	while((tail == edge_head) && (timeout_ms != 0)){
+		if(xSemaphoreTake(edge_available, (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms)) != pdTRUE){
+			return 0;
+		}
+	}
+	while((qty < max_qty) && (tail != edge_head)){
+		events[qty++] = edge_buffer[tail];
+		tail = (tail + 1) & (GPIO_EDGE_BUFFER_SIZE - 1);
+	}
+	edge_tail = tail;
+	return qty;
+}
+
+uint32_t GPIOEdgeOverflows(void){
+	return edge_overflows;
+}
+
 void GPIOActivInt(gpio_t pin, void *ptr_int_func, bool edge, void *args){
-	static bool isr_service_installed = false;
 	if(edge){
-		gpio_set_intr_type(gpio_list[pin].pin, GPIO_INTR_POSEDGE);
+		GPIOSetIntrType(pin, GPIO_INTR_POSEDGE);
 	} else{
-		gpio_set_intr_type(gpio_list[pin].pin, GPIO_INTR_NEGEDGE);
+		GPIOSetIntrType(pin, GPIO_INTR_NEGEDGE);
 	}
 	if(!isr_service_installed){	
 		gpio_install_isr_service(0);
@@ -116,6 +258,31 @@ void GPIOActivInt(gpio_t pin, void *ptr_int_func, bool edge, void *args){
     gpio_isr_handler_add(gpio_list[pin].pin, ptr_int_func, (void *)args);	
 }
 
+void GPIOActivIntAnyEdge(gpio_t pin, void *ptr_int_func, void *args){
+	GPIOSetIntrType(pin, GPIO_INTR_ANYEDGE);
+	if(!isr_service_installed){	
+		gpio_install_isr_service(0);
+		isr_service_installed = true;
+	}
+	gpio_isr_handler_add(gpio_list[pin].pin, ptr_int_func, (void *)args);
+}
+
+void GPIODeactivInt(gpio_t pin){
+	GPIOSetIntrType(pin, GPIO_INTR_DISABLE);
+	gpio_isr_handler_remove(gpio_list[pin].pin);
+}
+
+void GPIOWakeUpEnable(gpio_t pin, bool level){
+	gpio_wakeup_enable(gpio_list[pin].pin, level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+	esp_sleep_enable_gpio_wakeup();
+}
+
+void GPIOWakeUpDisable(gpio_t pin){
+	gpio_wakeup_disable(gpio_list[pin].pin);
+	/* Wake up changed the interruption to level: go back to the one set before */
+	gpio_set_intr_type(gpio_list[pin].pin, gpio_list[pin].intr_type);
+}
+
 void GPIOInputFilter(gpio_t pin){
 	static uint8_t filter_count = 0;
 	gpio_glitch_filter_handle_t filter;
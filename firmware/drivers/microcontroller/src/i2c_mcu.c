@@ -10,22 +10,366 @@
  */
 
 /*==================[inclusions]=============================================*/
+#include <string.h>
 #include <esp_log.h>
 #include <esp_err.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
 //#include "sdkconfig.h"
 
 #include "i2c_mcu.h"
 /*==================[macros and definitions]=================================*/
 #define I2C_NUM I2C_NUM_0
+#define I2C_CACHE_VALID		0x01	/*!< Shadow value matches the device (or will after commit) */
+#define I2C_CACHE_DIRTY		0x02	/*!< Shadow value not written to the device yet */
+#define I2C_CACHE_VOLATILE	0x04	/*!< Register changed by the device, never cached */
+#define I2C_PROBE_TIMEOUT_MS	10		/*!< Timeout of an address probe */
+#define I2C_FIRST_ADDR		0x08	/*!< First non reserved 7-bit address */
+#define I2C_LAST_ADDR		0x77	/*!< Last non reserved 7-bit address */
+#define I2C_JOB_TASK_STACK	3072	/*!< Bus manager task stack size */
+#define I2C_LOCK()		do { if(i2c_bus_lock != NULL) xSemaphoreTakeRecursive(i2c_bus_lock, portMAX_DELAY); } while(0)
+#define I2C_UNLOCK()	do { if(i2c_bus_lock != NULL) xSemaphoreGiveRecursive(i2c_bus_lock); } while(0)
 
 #undef ESP_ERROR_CHECK
 #define ESP_ERROR_CHECK(x)   do { esp_err_t rc = (x); if (rc != ESP_OK) { ESP_LOGE("err", "esp_err_t = %d", rc); /*assert(0 && #x);*/} } while(0);
 
+/*==================[typedef]================================================*/
+/**
+ * @brief Shadow register cache of a device
+ */
+typedef struct {
+	uint8_t devAddr;							/*!< I2C slave device address */
+	bool enabled;								/*!< Cache in use */
+	bool deferred;								/*!< Writes are kept until I2C_cacheCommit() */
+	uint8_t value[I2C_CACHE_REG_QTY];			/*!< Shadow register values */
+	uint8_t flags[I2C_CACHE_REG_QTY];			/*!< Register state (I2C_CACHE_VALID, I2C_CACHE_DIRTY, I2C_CACHE_VOLATILE) */
+} i2c_cache_t;
+
 /*==================[internal data definition]===============================*/
+static i2c_cache_t i2c_caches[I2C_CACHE_DEV_QTY];	/*!< Shadow register caches */
+static uint8_t cache_load_buffer[I2C_CACHE_REG_QTY];	/*!< Destination of I2C_cacheLoad() reads */
+static SemaphoreHandle_t i2c_bus_lock = NULL;		/*!< Bus access from tasks and the bus manager */
+static QueueHandle_t i2c_job_queues[I2C_JOB_PRIORITY_QTY];	/*!< Pending jobs, one queue per priority */
+static SemaphoreHandle_t i2c_job_count = NULL;		/*!< Number of pending jobs */
+static i2c_stats_t i2c_stats[I2C_STATS_DEV_QTY];	/*!< Per device statistics */
+static portMUX_TYPE i2c_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static i2c_device_t i2c_devices[I2C_DEVICE_QTY];	/*!< Registered devices */
+static i2c_config_t i2c_conf;						/*!< Bus configuration */
+static uint32_t i2c_default_speed;					/*!< Clock frequency of not registered devices */
 
 /*==================[internal functions declaration]=========================*/
+/**
+ * @brief Find the shadow register cache of a device
+ *
+ * @param devAddr I2C slave device address
+ * @return Cache of the device, NULL if the device has no cache
+ */
+static i2c_cache_t * I2C_cacheFind(uint8_t devAddr){
+	for(uint8_t i = 0; i < I2C_CACHE_DEV_QTY; i++){
+		if(i2c_caches[i].enabled && (i2c_caches[i].devAddr == devAddr)){
+			return &i2c_caches[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Check if a register can be kept in a cache
+ *
+ * @param cache Device cache
+ * @param regAddr Register address
+ * @return true if the register is cacheable
+ */
+static bool I2C_cacheable(i2c_cache_t *cache, uint16_t regAddr){
+	return (regAddr < I2C_CACHE_REG_QTY) && !(cache->flags[regAddr] & I2C_CACHE_VOLATILE);
+}
+
+/**
+ * @brief Find a registered device
+ *
+ * @param devAddr I2C slave device address
+ * @return Device entry, NULL if the device is not registered
+ */
+static i2c_device_t * I2C_deviceFind(uint8_t devAddr){
+	for(uint8_t i = 0; i < I2C_DEVICE_QTY; i++){
+		if(i2c_devices[i].registered && (i2c_devices[i].devAddr == devAddr)){
+			return &i2c_devices[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Maximum clock frequency of a device
+ *
+ * @param devAddr I2C slave device address
+ * @return Clock frequency in Hz
+ */
+static uint32_t I2C_deviceSpeed(uint8_t devAddr){
+	i2c_device_t *device = I2C_deviceFind(devAddr);
+	return (device != NULL) ? device->clk_speed : i2c_default_speed;
+}
+
+/**
+ * @brief Set the SCL frequency, only if it is different from the current one.
+ * Must be called with the bus locked.
+ *
+ * @param clk_speed Clock frequency in Hz
+ */
+static void I2C_busSpeed(uint32_t clk_speed){
+	if((clk_speed != 0) && (clk_speed != i2c_conf.master.clk_speed)){
+		i2c_conf.master.clk_speed = clk_speed;
+		i2c_param_config(I2C_NUM, &i2c_conf);
+	}
+}
+
+/**
+ * @brief Transaction timeout of a device
+ *
+ * @param devAddr I2C slave device address
+ * @param timeout Timeout in milliseconds (0 to use the device or I2C_MASTER_TIMEOUT_MS one)
+ * @return Timeout in ticks
+ */
+static TickType_t I2C_timeoutTicks(uint8_t devAddr, uint16_t timeout){
+	i2c_device_t *device;
+	if(timeout == 0){
+		device = I2C_deviceFind(devAddr);
+		timeout = ((device != NULL) && (device->timeout_ms != 0)) ? device->timeout_ms : I2C_MASTER_TIMEOUT_MS;
+	}
+	return pdMS_TO_TICKS(timeout);
+}
+
+/**
+ * @brief Write registers to the device, without going through the cache
+ *
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address
+ * @param length Number of bytes to write
+ * @param data Array of bytes to write
+ * @return Status of operation (true = success)
+ */
+static esp_err_t I2C_writeDevice(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout){
+	i2c_cmd_handle_t cmd;
+	esp_err_t rc;
+
+	cmd = i2c_cmd_link_create();
+	if(cmd == NULL){
+		return ESP_ERR_NO_MEM;
+	}
+	i2c_master_start(cmd);
+	i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1);
+	i2c_master_write_byte(cmd, regAddr, 1);
+	i2c_master_write(cmd, data, length, 1);
+	i2c_master_stop(cmd);
+	I2C_LOCK();
+	I2C_busSpeed(I2C_deviceSpeed(devAddr));
+	rc = i2c_master_cmd_begin(I2C_NUM, cmd, I2C_timeoutTicks(devAddr, timeout));
+	I2C_UNLOCK();
+	i2c_cmd_link_delete(cmd);
+	if(rc != ESP_OK){
+		ESP_LOGE("err", "esp_err_t = %d", rc);
+	}
+	return rc;
+}
+
+/**
+ * @brief Read registers, from the cache when possible
+ *
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address
+ * @param length Number of bytes to read
+ * @param data Buffer to store read data in
+ * @param timeout Timeout in milliseconds (0 to use I2C_MASTER_TIMEOUT_MS)
+ * @return ESP_OK on success
+ */
+static esp_err_t I2C_read(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout){
+	esp_err_t rc;
+	i2c_cache_t *cache;
+	uint8_t i;
+	if(length == 0){
+		return ESP_ERR_INVALID_ARG;
+	}
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	/* All the registers in cache: no bus transaction */
+	if(cache != NULL){
+		for(i = 0; i < length; i++){
+			if(!I2C_cacheable(cache, regAddr + i) || !(cache->flags[regAddr + i] & I2C_CACHE_VALID)){
+				break;
+			}
+		}
+		if(i == length){
+			memcpy(data, &cache->value[regAddr], length);
+			I2C_UNLOCK();
+			return ESP_OK;
+		}
+	}
+	/* Register address and data in one transaction (repeated start, no STOP in between) */
+	I2C_busSpeed(I2C_deviceSpeed(devAddr));
+	rc = i2c_master_write_read_device(I2C_NUM, devAddr, &regAddr, 1, data, length, I2C_timeoutTicks(devAddr, timeout));
+	if(rc != ESP_OK){
+		I2C_UNLOCK();
+		ESP_LOGE("err", "esp_err_t = %d", rc);
+		return rc;
+	}
+	if(cache != NULL){
+		for(i = 0; i < length; i++){
+			if(I2C_cacheable(cache, regAddr + i)){
+				if(cache->flags[regAddr + i] & I2C_CACHE_DIRTY){
+					/* Value not commited yet is newer than the device one */
+					data[i] = cache->value[regAddr + i];
+				} else{
+					cache->value[regAddr + i] = data[i];
+					cache->flags[regAddr + i] |= I2C_CACHE_VALID;
+				}
+			}
+		}
+	}
+	I2C_UNLOCK();
+	return ESP_OK;
+}
+
+/**
+ * @brief Write registers, keeping them in the cache when writes are deferred
+ *
+ * @param devAddr I2C slave device address
+ * @param regAddr First register address
+ * @param length Number of bytes to write
+ * @param data Array of bytes to write
+ * @param timeout Timeout in milliseconds (0 to use I2C_MASTER_TIMEOUT_MS)
+ * @return ESP_OK on success
+ */
+static esp_err_t I2C_write(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout){
+	i2c_cache_t *cache;
+	bool deferred;
+	uint8_t i;
+	esp_err_t rc;
+	if(length == 0){
+		return ESP_ERR_INVALID_ARG;
+	}
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache != NULL){
+		/* Writes can wait for commit only if all the registers are cached */
+		deferred = cache->deferred;
+		for(i = 0; i < length; i++){
+			if(!I2C_cacheable(cache, regAddr + i)){
+				deferred = false;
+			}
+		}
+		for(i = 0; i < length; i++){
+			if(I2C_cacheable(cache, regAddr + i)){
+				cache->value[regAddr + i] = data[i];
+				cache->flags[regAddr + i] = deferred ? (I2C_CACHE_VALID | I2C_CACHE_DIRTY) : I2C_CACHE_VALID;
+			}
+		}
+		if(deferred){
+			I2C_UNLOCK();
+			return ESP_OK;
+		}
+	}
+	rc = I2C_writeDevice(devAddr, regAddr, length, data, timeout);
+	if((rc != ESP_OK) && (cache != NULL)){
+		/* The device may not have the new values: read them again next time */
+		for(i = 0; i < length; i++){
+			if(I2C_cacheable(cache, regAddr + i)){
+				cache->flags[regAddr + i] = 0;
+			}
+		}
+	}
+	I2C_UNLOCK();
+	return rc;
+}
+
+/**
+ * @brief Statistics entry of a device (a new one is assigned on first use)
+ *
+ * @param devAddr I2C slave device address
+ * @return Statistics entry, NULL if the table is full
+ */
+static i2c_stats_t * I2C_statsFind(uint8_t devAddr){
+	for(uint8_t i = 0; i < I2C_STATS_DEV_QTY; i++){
+		if(i2c_stats[i].used && (i2c_stats[i].devAddr == devAddr)){
+			return &i2c_stats[i];
+		}
+	}
+	for(uint8_t i = 0; i < I2C_STATS_DEV_QTY; i++){
+		if(!i2c_stats[i].used){
+			i2c_stats[i].used = true;
+			i2c_stats[i].devAddr = devAddr;
+			return &i2c_stats[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Bus manager task: runs queued jobs, highest priority first
+ *
+ * @param pvParameter Not used
+ */
+static void I2C_jobTask(void *pvParameter){
+	i2c_job_t *job;
+	i2c_stats_t *stats;
+	int64_t start, end;
+	uint8_t prio;
+	uint16_t timeout;
+	while(true){
+		xSemaphoreTake(i2c_job_count, portMAX_DELAY);
+		job = NULL;
+		for(prio = 0; prio < I2C_JOB_PRIORITY_QTY; prio++){
+			if(xQueueReceive(i2c_job_queues[prio], &job, 0) == pdTRUE){
+				break;
+			}
+		}
+		if(job == NULL){
+			continue;
+		}
+		start = esp_timer_get_time();
+		timeout = 0;
+		if(job->deadline_ms != 0){
+			/* The transaction can use the time left until the deadline */
+			if(start >= job->expiry_us){
+				job->result = ESP_ERR_TIMEOUT;
+			} else{
+				timeout = ((job->expiry_us - start) / 1000 < UINT16_MAX) ? (job->expiry_us - start + 999) / 1000 : UINT16_MAX;
+			}
+		}
+		if(job->result != ESP_ERR_TIMEOUT){
+			if(job->type == I2C_JOB_READ){
+				job->result = I2C_read(job->devAddr, job->regAddr, job->length, job->data, timeout);
+			} else{
+				job->result = I2C_write(job->devAddr, job->regAddr, job->length, job->data, timeout);
+			}
+		}
+		end = esp_timer_get_time();
+		portENTER_CRITICAL(&i2c_stats_mux);
+		stats = I2C_statsFind(job->devAddr);
+		if(stats != NULL){
+			stats->jobs++;
+			if(job->result == ESP_ERR_TIMEOUT){
+				stats->timeouts++;
+			} else if(job->result != ESP_OK){
+				stats->errors++;
+			}
+			stats->last_latency_us = end - job->submit_us;
+			if(stats->last_latency_us > stats->max_latency_us){
+				stats->max_latency_us = stats->last_latency_us;
+			}
+			stats->total_latency_us += stats->last_latency_us;
+		}
+		portEXIT_CRITICAL(&i2c_stats_mux);
+		job->done = true;
+		if(job->func_p != NULL){
+			job->func_p(job->param_p);
+		}
+		/* Last access to the job: after this it can be reused or released */
+		xSemaphoreGive(job->done_sem);
+	}
+}
 
 /*==================[external functions definition]==========================*/
 
@@ -45,6 +389,11 @@ bool I2C_initialize( uint32_t clockRateHz )
     };
 
     i2c_param_config(i2c_master_port, &conf);
+	i2c_conf = conf;
+	i2c_default_speed = clockRateHz;
+	if(i2c_bus_lock == NULL){
+		i2c_bus_lock = xSemaphoreCreateRecursiveMutex();
+	}
 
     return i2c_driver_install(i2c_master_port, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0);
 	return true;
@@ -120,27 +469,66 @@ int8_t I2C_readByte(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t ti
  * @param regAddr First register regAddr to read from
  * @param length Number of bytes to read
  * @param data Buffer to store read data in
- * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2C_readTimeout)
- * @return I2C_TransferReturn_TypeDef http://downloads.energymicro.com/documentation/doxygen/group__I2C.html
+ * @param timeout Optional read timeout in milliseconds (0 to use I2C_MASTER_TIMEOUT_MS)
+ * @return Number of bytes read (0 = error)
  */
 int8_t I2C_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
+	return (I2C_read(devAddr, regAddr, length, data, timeout) == ESP_OK) ? length : 0;
+}
+
+/** Read registers of several devices in one bus transaction.
+ * Every read is a repeated start (address + register, address + data), and there is a
+ * single STOP at the end, so the bus is acquired only once.
+ * @param reads Array of reads to perform
+ * @param qty Number of reads
+ * @param timeout Optional read timeout in milliseconds (0 to use I2C_MASTER_TIMEOUT_MS)
+ * @return Number of reads performed (qty = success, 0 = error)
+ */
+bool I2C_readBytesMulti(i2c_read_t *reads, uint8_t qty, uint16_t timeout) {
 	i2c_cmd_handle_t cmd;
-	I2C_SelectRegister(devAddr, regAddr);
+	esp_err_t rc;
+	uint32_t clk_speed = UINT32_MAX;
+	TickType_t ticks = 0;
 
 	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_READ, 1));
-
-	if(length>1)
-	ESP_ERROR_CHECK(i2c_master_read(cmd, data, length-1, I2C_MASTER_ACK));
-
-	ESP_ERROR_CHECK(i2c_master_read_byte(cmd, data+length-1, I2C_MASTER_NACK));
-
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS));
+	if(cmd == NULL){
+		return false;
+	}
+	for(uint8_t i = 0; i < qty; i++){
+		if(reads[i].length == 0){
+			continue;
+		}
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (reads[i].devAddr << 1) | I2C_MASTER_WRITE, 1);
+		i2c_master_write_byte(cmd, reads[i].regAddr, 1);
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (reads[i].devAddr << 1) | I2C_MASTER_READ, 1);
+		i2c_master_read(cmd, reads[i].data, reads[i].length, I2C_MASTER_LAST_NACK);
+		/* The whole transaction runs at the speed of the slowest device */
+		if(I2C_deviceSpeed(reads[i].devAddr) < clk_speed){
+			clk_speed = I2C_deviceSpeed(reads[i].devAddr);
+		}
+		/* ...and gets the longest timeout of the devices involved */
+		if(I2C_timeoutTicks(reads[i].devAddr, timeout) > ticks){
+			ticks = I2C_timeoutTicks(reads[i].devAddr, timeout);
+		}
+	}
+	if(ticks == 0){
+		ticks = pdMS_TO_TICKS((timeout != 0) ? timeout : I2C_MASTER_TIMEOUT_MS);
+	}
+	i2c_master_stop(cmd);
+	I2C_LOCK();
+	if(clk_speed != UINT32_MAX){
+		I2C_busSpeed(clk_speed);
+	}
+	rc = i2c_master_cmd_begin(I2C_NUM, cmd, ticks);
+	I2C_UNLOCK();
 	i2c_cmd_link_delete(cmd);
-
-	return length;
+	if(rc != ESP_OK){
+		ESP_LOGE("err", "esp_err_t = %d", rc);
+		return false;
+	}
+	return true;
 }
 
 bool I2C_writeWord(uint8_t devAddr, uint8_t regAddr, uint16_t data){
@@ -158,7 +546,10 @@ void I2C_SelectRegister(uint8_t devAddr, uint8_t reg){
 	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
 	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, reg, 1));
 	ESP_ERROR_CHECK(i2c_master_stop(cmd));
+	I2C_LOCK();
+	I2C_busSpeed(I2C_deviceSpeed(devAddr));
 	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS));
+	I2C_UNLOCK();
 	i2c_cmd_link_delete(cmd);
 }
 
@@ -171,9 +562,14 @@ void I2C_SelectRegister(uint8_t devAddr, uint8_t reg){
  */
 bool I2C_writeBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t data) {
     uint8_t b;
-    I2C_readByte(devAddr, regAddr, &b, 0);
-    b = (data != 0) ? (b | (1 << bitNum)) : (b & ~(1 << bitNum));
-    return I2C_writeByte(devAddr, regAddr, b);
+    bool rc = false;
+    I2C_LOCK();
+    if (I2C_readByte(devAddr, regAddr, &b, 0) != 0) {
+        b = (data != 0) ? (b | (1 << bitNum)) : (b & ~(1 << bitNum));
+        rc = I2C_writeByte(devAddr, regAddr, b);
+    }
+    I2C_UNLOCK();
+    return rc;
 }
 
 /** Write multiple bits in an 8-bit device register.
@@ -193,16 +589,18 @@ bool I2C_writeBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t l
     // 10100011 original & ~mask
     // 10101011 masked | value
     uint8_t b = 0;
+    bool rc = false;
+    I2C_LOCK();
     if (I2C_readByte(devAddr, regAddr, &b, 0) != 0) {
         uint8_t mask = ((1 << length) - 1) << (bitStart - length + 1);
         data <<= (bitStart - length + 1); // shift data into correct position
         data &= mask; // zero all non-important bits in data
         b &= ~(mask); // zero all important bits in existing byte
         b |= data; // combine data with existing byte
-        return I2C_writeByte(devAddr, regAddr, b);
-    } else {
-        return false;
+        rc = I2C_writeByte(devAddr, regAddr, b);
     }
+    I2C_UNLOCK();
+    return rc;
 }
 
 /** Write single byte to an 8-bit device register.
@@ -212,18 +610,7 @@ bool I2C_writeBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t l
  * @return Status of operation (true = success)
  */
 bool I2C_writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
-	i2c_cmd_handle_t cmd;
-
-	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, regAddr, 1));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, data, 1));
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	ESP_ERROR_CHECK(i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS));
-	i2c_cmd_link_delete(cmd);
-
-	return true;
+	return I2C_writeBytes(devAddr, regAddr, 1, &data);
 }
 
 /** Write single byte to an 8-bit device register.
@@ -234,20 +621,260 @@ bool I2C_writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
  * @return Status of operation (true = success)
  */
 bool I2C_writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data){
+	return (I2C_write(devAddr, regAddr, length, data, 0) == ESP_OK);
+}
+
+bool I2C_cacheEnable(uint8_t devAddr){
+	i2c_cache_t *cache;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	for(uint8_t i = 0; (i < I2C_CACHE_DEV_QTY) && (cache == NULL); i++){
+		if(!i2c_caches[i].enabled){
+			cache = &i2c_caches[i];
+			memset(cache, 0, sizeof(i2c_cache_t));
+			cache->devAddr = devAddr;
+			cache->enabled = true;
+		}
+	}
+	I2C_UNLOCK();
+	return (cache != NULL);
+}
+
+void I2C_cacheDisable(uint8_t devAddr){
+	i2c_cache_t *cache;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache != NULL){
+		I2C_cacheCommit(devAddr);
+		cache->enabled = false;
+	}
+	I2C_UNLOCK();
+}
+
+void I2C_cacheVolatile(uint8_t devAddr, uint8_t regAddr, uint8_t length){
+	i2c_cache_t *cache;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache != NULL){
+		for(uint16_t reg = regAddr; (reg < regAddr + length) && (reg < I2C_CACHE_REG_QTY); reg++){
+			cache->flags[reg] = I2C_CACHE_VOLATILE;
+		}
+	}
+	I2C_UNLOCK();
+}
+
+void I2C_cacheInvalidate(uint8_t devAddr){
+	i2c_cache_t *cache;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache != NULL){
+		for(uint16_t reg = 0; reg < I2C_CACHE_REG_QTY; reg++){
+			cache->flags[reg] &= I2C_CACHE_VOLATILE;
+		}
+	}
+	I2C_UNLOCK();
+}
+
+bool I2C_cacheLoad(uint8_t devAddr, uint8_t regAddr, uint8_t length){
+	i2c_cache_t *cache;
+	uint16_t first, last, end;
+	bool ok = true;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache == NULL){
+		I2C_UNLOCK();
+		return false;
+	}
+	end = regAddr + length;
+	if(end > I2C_CACHE_REG_QTY){
+		end = I2C_CACHE_REG_QTY;
+	}
+	/* Values already cached are read again (pending writes are kept, they are newer) */
+	for(first = regAddr; first < end; first++){
+		if(!(cache->flags[first] & I2C_CACHE_DIRTY)){
+			cache->flags[first] &= ~I2C_CACHE_VALID;
+		}
+	}
+	/* One burst per run of cacheable registers: volatile ones are never read */
+	for(first = regAddr; first < end; first = last){
+		if(!I2C_cacheable(cache, first)){
+			last = first + 1;
+			continue;
+		}
+		for(last = first; (last < end) && I2C_cacheable(cache, last); last++);
+		if(I2C_read(devAddr, first, last - first, &cache_load_buffer[first], 0) != ESP_OK){
+			ok = false;
+		}
+	}
+	I2C_UNLOCK();
+	return ok;
+}
+
+bool I2C_cacheDefer(uint8_t devAddr, bool defer){
+	i2c_cache_t *cache;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache != NULL){
+		cache->deferred = defer;
+	}
+	I2C_UNLOCK();
+	return (cache != NULL);
+}
+
+bool I2C_cacheCommit(uint8_t devAddr){
+	i2c_cache_t *cache;
+	bool ok = true;
+	uint16_t first, last;
+	I2C_LOCK();
+	cache = I2C_cacheFind(devAddr);
+	if(cache == NULL){
+		I2C_UNLOCK();
+		return true;
+	}
+	/* Every run of consecutive dirty registers is written in one transaction (register auto-increment) */
+	for(first = 0; first < I2C_CACHE_REG_QTY; first = last){
+		if(!(cache->flags[first] & I2C_CACHE_DIRTY)){
+			last = first + 1;
+			continue;
+		}
+		for(last = first; (last < I2C_CACHE_REG_QTY) && (cache->flags[last] & I2C_CACHE_DIRTY); last++);
+		if(I2C_writeDevice(devAddr, first, last - first, &cache->value[first], 0) == ESP_OK){
+			for(uint16_t reg = first; reg < last; reg++){
+				cache->flags[reg] &= ~I2C_CACHE_DIRTY;
+			}
+		} else{
+			ok = false;
+		}
+	}
+	I2C_UNLOCK();
+	return ok;
+}
+
+bool I2C_deviceRegister(uint8_t devAddr, uint32_t clk_speed, uint16_t timeout_ms){
+	i2c_device_t *device = I2C_deviceFind(devAddr);
+	for(uint8_t i = 0; (i < I2C_DEVICE_QTY) && (device == NULL); i++){
+		if(!i2c_devices[i].registered){
+			device = &i2c_devices[i];
+		}
+	}
+	if(device == NULL){
+		return false;
+	}
+	I2C_LOCK();
+	device->devAddr = devAddr;
+	device->clk_speed = (clk_speed != 0) ? clk_speed : i2c_default_speed;
+	device->timeout_ms = timeout_ms;
+	device->registered = true;
+	I2C_UNLOCK();
+	return true;
+}
+
+bool I2C_deviceProbe(uint8_t devAddr){
 	i2c_cmd_handle_t cmd;
+	esp_err_t rc;
+	i2c_device_t *device;
 
 	cmd = i2c_cmd_link_create();
-	ESP_ERROR_CHECK(i2c_master_start(cmd));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, regAddr, 1));
-	ESP_ERROR_CHECK(i2c_master_write(cmd, data, length-1, 0));
-	ESP_ERROR_CHECK(i2c_master_write_byte(cmd, data[length-1], 1));
-	ESP_ERROR_CHECK(i2c_master_stop(cmd));
-	i2c_master_cmd_begin(I2C_NUM, cmd, 1000/portTICK_PERIOD_MS);
+	if(cmd == NULL){
+		return false;
+	}
+	i2c_master_start(cmd);
+	i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, 1);
+	i2c_master_stop(cmd);
+	I2C_LOCK();
+	I2C_busSpeed(I2C_deviceSpeed(devAddr));
+	rc = i2c_master_cmd_begin(I2C_NUM, cmd, pdMS_TO_TICKS(I2C_PROBE_TIMEOUT_MS));
+	device = I2C_deviceFind(devAddr);
+	if(device != NULL){
+		device->present = (rc == ESP_OK);
+	}
+	I2C_UNLOCK();
 	i2c_cmd_link_delete(cmd);
+	return (rc == ESP_OK);
+}
+
+uint8_t I2C_scan(uint8_t *found, uint8_t max_qty){
+	uint8_t qty = 0;
+	for(uint8_t addr = I2C_FIRST_ADDR; addr <= I2C_LAST_ADDR; addr++){
+		if(I2C_deviceProbe(addr)){
+			if((found != NULL) && (qty < max_qty)){
+				found[qty] = addr;
+			}
+			qty++;
+		}
+	}
+	return qty;
+}
+
+bool I2C_devicePresent(uint8_t devAddr){
+	i2c_device_t *device = I2C_deviceFind(devAddr);
+	return (device != NULL) && device->present;
+}
+
+bool I2C_jobManagerInit(UBaseType_t priority){
+	if(i2c_job_count != NULL){
+		return true;
+	}
+	for(uint8_t i = 0; i < I2C_JOB_PRIORITY_QTY; i++){
+		i2c_job_queues[i] = xQueueCreate(I2C_JOB_QUEUE_SIZE, sizeof(i2c_job_t *));
+		if(i2c_job_queues[i] == NULL){
+			return false;
+		}
+	}
+	i2c_job_count = xSemaphoreCreateCounting(I2C_JOB_QUEUE_SIZE * I2C_JOB_PRIORITY_QTY, 0);
+	if(i2c_job_count == NULL){
+		return false;
+	}
+	return (xTaskCreate(&I2C_jobTask, "I2C", I2C_JOB_TASK_STACK, NULL, priority, NULL) == pdPASS);
+}
+
+bool I2C_jobSubmit(i2c_job_t *job){
+	if((i2c_job_count == NULL) || (job->priority >= I2C_JOB_PRIORITY_QTY)){
+		return false;
+	}
+	job->done = false;
+	job->result = ESP_OK;
+	/* Static semaphore: no memory is allocated, a job can be submitted again once done */
+	job->done_sem = xSemaphoreCreateBinaryStatic(&job->done_sem_buffer);
+	job->submit_us = esp_timer_get_time();
+	job->expiry_us = job->submit_us + (int64_t)job->deadline_ms * 1000;
+	if(xQueueSend(i2c_job_queues[job->priority], &job, 0) != pdTRUE){
+		return false;
+	}
+	xSemaphoreGive(i2c_job_count);
+	return true;
+}
+
+bool I2C_jobWait(i2c_job_t *job, uint32_t timeout_ms){
+	TickType_t ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+	/* Only the bus manager gives the semaphore (once, after its last access to the job),
+	 * so a single take is bounded by the timeout */
+	if(xSemaphoreTake(job->done_sem, ticks) != pdTRUE){
+		return false;
+	}
+	/* Left given: later waits for the same job return at once */
+	xSemaphoreGive(job->done_sem);
 	return true;
 }
 
+bool I2C_getStats(uint8_t devAddr, i2c_stats_t *stats){
+	bool found = false;
+	portENTER_CRITICAL(&i2c_stats_mux);
+	for(uint8_t i = 0; i < I2C_STATS_DEV_QTY; i++){
+		if(i2c_stats[i].used && (i2c_stats[i].devAddr == devAddr)){
+			*stats = i2c_stats[i];
+			found = true;
+		}
+	}
+	portEXIT_CRITICAL(&i2c_stats_mux);
+	return found;
+}
+
+void I2C_resetStats(void){
+	portENTER_CRITICAL(&i2c_stats_mux);
+	memset(i2c_stats, 0, sizeof(i2c_stats));
+	portEXIT_CRITICAL(&i2c_stats_mux);
+}
 
 /**
  * read word
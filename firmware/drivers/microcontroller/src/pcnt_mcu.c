@@ -0,0 +1,185 @@
+/**
+ * @file pcnt_mcu.c
+ * @author Eric Beauchamps (beauchampseric97@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+/*==================[inclusions]=============================================*/
+#include "pcnt_mcu.h"
+#include "driver/pulse_cnt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+/*==================[macros and definitions]=================================*/
+#define PCNT_QTY	4		/*!< Number of pulse counters */
+/*==================[internal data declaration]==============================*/
+/**
+ * @brief Pulse counter data
+ */
+typedef struct {
+	pcnt_unit_handle_t handle;		/*!< IDF unit handle */
+	pcnt_channel_handle_t chan_a;	/*!< Channel with edges on pin_a */
+	pcnt_channel_handle_t chan_b;	/*!< Channel with edges on pin_b (quadrature mode) */
+	int64_t accum;					/*!< Count extended to 64 bits */
+	int last;						/*!< IDF count at the last read */
+} pcnt_data_t;
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+static pcnt_data_t pcnt_units[PCNT_QTY];
+static portMUX_TYPE pcnt_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/*==================[external functions definition]==========================*/
+bool PcntInit(pcnt_mcu_config_t *pcnt_ini){
+	pcnt_data_t *pcnt = &pcnt_units[pcnt_ini->unit];
+	pcnt_unit_config_t unit_config = {
+		.low_limit = -PCNT_LIMIT,
+		.high_limit = PCNT_LIMIT,
+		/* The IDF accumulates hardware overflows (race free with the counter read) */
+		.flags.accum_count = 1,
+	};
+	pcnt_chan_config_t chan_config = {
+		.edge_gpio_num = pcnt_ini->pin_a,
+		.level_gpio_num = -1,
+	};
+
+	PcntDeinit(pcnt_ini->unit);
+	if(pcnt_new_unit(&unit_config, &pcnt->handle) != ESP_OK){
+		pcnt->handle = NULL;
+		return false;
+	}
+	if(pcnt_ini->glitch_ns > 0){
+		pcnt_glitch_filter_config_t filter_config = {
+			.max_glitch_ns = pcnt_ini->glitch_ns,
+		};
+		pcnt_unit_set_glitch_filter(pcnt->handle, &filter_config);
+	}
+	if(pcnt_ini->mode == PCNT_QUADRATURE){
+		chan_config.level_gpio_num = pcnt_ini->pin_b;
+	}
+	if(pcnt_new_channel(pcnt->handle, &chan_config, &pcnt->chan_a) != ESP_OK){
+		pcnt->chan_a = NULL;
+		PcntDeinit(pcnt_ini->unit);
+		return false;
+	}
+	switch(pcnt_ini->mode){
+		case PCNT_RISING_EDGE:
+			pcnt_channel_set_edge_action(pcnt->chan_a, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
+		break;
+		case PCNT_FALLING_EDGE:
+			pcnt_channel_set_edge_action(pcnt->chan_a, PCNT_CHANNEL_EDGE_ACTION_HOLD, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+		break;
+		case PCNT_BOTH_EDGES:
+			pcnt_channel_set_edge_action(pcnt->chan_a, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+		break;
+		case PCNT_QUADRATURE:
+			/* Edges of each channel count up or down depending on the level of the other one */
+			pcnt_channel_set_edge_action(pcnt->chan_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+			pcnt_channel_set_level_action(pcnt->chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+			chan_config.edge_gpio_num = pcnt_ini->pin_b;
+			chan_config.level_gpio_num = pcnt_ini->pin_a;
+			if(pcnt_new_channel(pcnt->handle, &chan_config, &pcnt->chan_b) != ESP_OK){
+				pcnt->chan_b = NULL;
+				PcntDeinit(pcnt_ini->unit);
+				return false;
+			}
+			pcnt_channel_set_edge_action(pcnt->chan_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+			pcnt_channel_set_level_action(pcnt->chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+		break;
+	}
+	/* Only one interruption every PCNT_LIMIT counts, to extend the count */
+	pcnt_unit_add_watch_point(pcnt->handle, PCNT_LIMIT);
+	pcnt_unit_add_watch_point(pcnt->handle, -PCNT_LIMIT);
+	pcnt->accum = 0;
+	pcnt->last = 0;
+	pcnt_unit_enable(pcnt->handle);
+	pcnt_unit_clear_count(pcnt->handle);
+	return true;
+}
+
+void PcntStart(pcnt_mcu_t unit){
+	if(pcnt_units[unit].handle != NULL){
+		pcnt_unit_start(pcnt_units[unit].handle);
+	}
+}
+
+void PcntStop(pcnt_mcu_t unit){
+	if(pcnt_units[unit].handle != NULL){
+		pcnt_unit_stop(pcnt_units[unit].handle);
+	}
+}
+
+void PcntReset(pcnt_mcu_t unit){
+	if(pcnt_units[unit].handle != NULL){
+		portENTER_CRITICAL(&pcnt_mux);
+		pcnt_unit_clear_count(pcnt_units[unit].handle);
+		pcnt_units[unit].accum = 0;
+		pcnt_units[unit].last = 0;
+		portEXIT_CRITICAL(&pcnt_mux);
+	}
+}
+
+int64_t PcntRead(pcnt_mcu_t unit){
+	pcnt_data_t *pcnt = &pcnt_units[unit];
+	int64_t accum;
+	int count = 0;
+	if(pcnt->handle == NULL){
+		return 0;
+	}
+	/* IDF count is 32 bits: extend it with the difference from the last read (wraps safely) */
+	portENTER_CRITICAL(&pcnt_mux);
+	pcnt_unit_get_count(pcnt->handle, &count);
+	pcnt->accum += (int32_t)((uint32_t)count - (uint32_t)pcnt->last);
+	pcnt->last = count;
+	accum = pcnt->accum;
+	portEXIT_CRITICAL(&pcnt_mux);
+	return accum;
+}
+
+int32_t PcntRead32(pcnt_mcu_t unit){
+	return (int32_t)PcntRead(unit);
+}
+
+uint32_t PcntFrequency(pcnt_mcu_t unit, uint32_t gate_ms){
+	int64_t count, time_us;
+	count = PcntRead(unit);
+	time_us = esp_timer_get_time();
+	vTaskDelay(pdMS_TO_TICKS(gate_ms));
+	count = PcntRead(unit) - count;
+	time_us = esp_timer_get_time() - time_us;
+	if(count < 0){
+		count = -count;
+	}
+	/* Actual elapsed time is used, the task may wake up late */
+	return (time_us > 0) ? (uint32_t)((count * 1000000 + time_us / 2) / time_us) : 0;
+}
+
+void PcntDeinit(pcnt_mcu_t unit){
+	pcnt_data_t *pcnt = &pcnt_units[unit];
+	if(pcnt->handle == NULL){
+		return;
+	}
+	pcnt_unit_stop(pcnt->handle);
+	pcnt_unit_disable(pcnt->handle);
+	if(pcnt->chan_a != NULL){
+		pcnt_del_channel(pcnt->chan_a);
+		pcnt->chan_a = NULL;
+	}
+	if(pcnt->chan_b != NULL){
+		pcnt_del_channel(pcnt->chan_b);
+		pcnt->chan_b = NULL;
+	}
+	pcnt_del_unit(pcnt->handle);
+	pcnt->handle = NULL;
+}
+
+/*==================[end of file]============================================*/
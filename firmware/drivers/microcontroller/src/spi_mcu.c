@@ -14,6 +14,9 @@
 #include <stdint.h>
 #include <string.h>
 #include "driver/spi_master.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+#include "soc/gpio_reg.h"
 #include "gpio_mcu.h"
 /*==================[macros and definitions]=================================*/
 #define PIN_NUM_MISO	GPIO_22	/*!<  */
@@ -22,83 +25,198 @@
 #define PIN_NUM_CS1		GPIO_19	/*!<  */
 #define PIN_NUM_CS2		GPIO_18	/*!<  */
 #define PIN_NUM_CS3		GPIO_9	/*!<  */
+#define SPI_DEV_QTY		3		/*!< Number of SPI devices */
+#define SPI_DMA_ALIGN	4		/*!< DMA buffers alignment (in bytes) */
+#define SPI_TXDATA_SIZE	4		/*!< Maximum number of bytes sent from the transaction itself */
 /*==================[internal data declaration]==============================*/
-spi_device_handle_t spi_1, spi_2, spi_3;
+/**
+ * @brief SPI device data
+ */
+typedef struct{
+	spi_device_handle_t handle;					/*!< ESP-IDF device handle */
+	transfer_mode_t transfer_mode;				/*!< Transfer mode for blocking functions */
+	void (*isr_p)(void*);						/*!< Pointer to callback function for transaction end */
+	void *user_data;							/*!< Pointer to callback parameter */
+	spi_transaction_t trans[SPI_QUEUE_SIZE];	/*!< Ring of transactions used by queued transfers */
+	uint8_t head;								/*!< Next free transaction of the ring */
+	uint8_t pending;							/*!< Queued transactions whose result was not collected yet */
+	uint32_t dc_mask;							/*!< Bit mask of the D/C pin (0: no D/C pin) */
+} spi_dev_data_t;
+
+spi_dev_data_t spi_devs[SPI_DEV_QTY];
 const spi_bus_config_t bus_cfg = {
     .miso_io_num = PIN_NUM_MISO,
     .mosi_io_num = PIN_NUM_MOSI,
     .sclk_io_num = PIN_NUM_CLK,
     .quadwp_io_num = -1,
     .quadhd_io_num = -1,
-    .max_transfer_sz = 4092
+    .max_transfer_sz = SPI_MAX_CHUNK_SIZE
 };
-transfer_mode_t transfer_mode_1, transfer_mode_2, transfer_mode_3;
-void (*spi_1_isr_p)(void*);	/*!<  */
-void (*spi_2_isr_p)(void*);	/*!<  */
-void (*spi_3_isr_p)(void*);	/*!<  */
-void *spi_1_user_data;	    /*!<  */
-void *spi_2_user_data;	    /*!<  */
-void *spi_3_user_data;	    /*!<  */
+const int spi_cs_pins[SPI_DEV_QTY] = {PIN_NUM_CS1, PIN_NUM_CS2, PIN_NUM_CS3};
+portMUX_TYPE spi_mux = portMUX_INITIALIZER_UNLOCKED;
+QueueHandle_t spi_buffer_pool = NULL;	/*!< Free DMA buffers */
+uint32_t spi_buffer_size = 0;			/*!< Size of DMA buffers */
+uint8_t spi_buffer_qty = 0;				/*!< Number of DMA buffers in the pool */
 /*==================[internal functions declaration]=========================*/
+/**
+ * @brief Called from ISR right before every transaction of a device starts
+ *
+ * @param dev SPI device data
+ * @param t Transaction about to start
+ */
+static void IRAM_ATTR SpiTransactionStart(spi_dev_data_t *dev, spi_transaction_t *t){
+	spi_transfer_t *transfer = t->user;
+	if((transfer == NULL) || (dev->dc_mask == 0)){
+		return;
+	}
+	switch(transfer->dc){
+		case SPI_DC_COMMAND:
+			REG_WRITE(GPIO_OUT_W1TC_REG, dev->dc_mask);
+			break;
+		case SPI_DC_DATA:
+			REG_WRITE(GPIO_OUT_W1TS_REG, dev->dc_mask);
+			break;
+		default:
+			break;
+	}
+}
+static void IRAM_ATTR spi_1_pre_isr(spi_transaction_t *t){
+	SpiTransactionStart(&spi_devs[SPI_1], t);
+}
+static void IRAM_ATTR spi_2_pre_isr(spi_transaction_t *t){
+	SpiTransactionStart(&spi_devs[SPI_2], t);
+}
+static void IRAM_ATTR spi_3_pre_isr(spi_transaction_t *t){
+	SpiTransactionStart(&spi_devs[SPI_3], t);
+}
+const transaction_cb_t spi_pre_isrs[SPI_DEV_QTY] = {spi_1_pre_isr, spi_2_pre_isr, spi_3_pre_isr};
+
+/**
+ * @brief Called from ISR at the end of every transaction of a device
+ *
+ * @param dev SPI device data
+ * @param t Finished transaction
+ */
+static void IRAM_ATTR SpiTransactionEnd(spi_dev_data_t *dev, spi_transaction_t *t){
+	spi_transfer_t *transfer = t->user;
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	if(transfer == NULL){
+		/* Blocking transfer */
+		if((dev->transfer_mode == SPI_INTERRUPT) && (dev->isr_p != NULL)){
+			dev->isr_p(dev->user_data);
+		}
+		return;
+	}
+	/* Queued transfer: signal only when its last transaction ends */
+	if(--transfer->pending == 0){
+		transfer->done = true;
+		if(transfer->func_p != NULL){
+			((void (*)(void*))transfer->func_p)(transfer->param_p);
+		}
+		if(transfer->task_to_notify != NULL){
+			vTaskNotifyGiveFromISR(transfer->task_to_notify, &xHigherPriorityTaskWoken);
+			portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+		}
+	}
+}
 static void IRAM_ATTR spi_1_isr(spi_transaction_t *t){
-	spi_1_isr_p(spi_1_user_data);
+	SpiTransactionEnd(&spi_devs[SPI_1], t);
 }
 static void IRAM_ATTR spi_2_isr(spi_transaction_t *t){
-	spi_2_isr_p(spi_2_user_data);
+	SpiTransactionEnd(&spi_devs[SPI_2], t);
 }
 static void IRAM_ATTR spi_3_isr(spi_transaction_t *t){
-	spi_3_isr_p(spi_3_user_data);
+	SpiTransactionEnd(&spi_devs[SPI_3], t);
 }
+const transaction_cb_t spi_isrs[SPI_DEV_QTY] = {spi_1_isr, spi_2_isr, spi_3_isr};
 /*==================[internal data definition]===============================*/
 
 /*==================[external data definition]===============================*/
 
 /*==================[internal functions definition]==========================*/
+/**
+ * @brief Collect the result of the oldest queued transaction of a device
+ *
+ * @param dev SPI device data
+ * @param ticks Maximum time to wait
+ * @return true if a result was collected
+ */
+static bool SpiCollectResult(spi_dev_data_t *dev, TickType_t ticks){
+	spi_transaction_t *t;
+	if(spi_device_get_trans_result(dev->handle, &t, ticks) != ESP_OK){
+		return false;
+	}
+	dev->pending--;
+	return true;
+}
 
+/**
+ * @brief Execute a blocking transaction
+ *
+ * @note Queued transfers of the device are finished first, so transactions keep
+ * their order (and polling transactions are not mixed with queued ones).
+ *
+ * @param device SPI device
+ * @param t Transaction
+ */
+static void SpiTransmit(spi_dev_t device, spi_transaction_t *t){
+	spi_dev_data_t *dev = &spi_devs[device];
+	spi_transfer_t transfer;
+	/* Large transfer: queue all the chunks back to back and wait for them */
+	if(t->length > SPI_MAX_CHUNK_SIZE * 8){
+		memset(&transfer, 0, sizeof(transfer));
+		transfer.tx_buffer = (uint8_t *)t->tx_buffer;
+		transfer.rx_buffer = t->rx_buffer;
+		transfer.size = t->length / 8;
+		if(dev->transfer_mode == SPI_INTERRUPT){
+			transfer.func_p = dev->isr_p;
+			transfer.param_p = dev->user_data;
+		}
+		if(SpiQueueTransfer(device, &transfer)){
+			SpiWaitTransfers(device, portMAX_DELAY);
+		}
+		return;
+	}
+	while(dev->pending > 0){
+		SpiCollectResult(dev, portMAX_DELAY);
+	}
+	switch(dev->transfer_mode){
+		case SPI_POLLING:
+			spi_device_polling_transmit(dev->handle, t);
+			break;
+		case SPI_INTERRUPT:
+			spi_device_transmit(dev->handle, t);
+			break;
+	}
+}
 /*==================[external functions definition]==========================*/
 uint8_t SpiInit(spi_mcu_config_t* spi){
     static bool spi_initialized = false;
+	spi_dev_data_t *dev = &spi_devs[spi->device];
     if(!spi_initialized){
 	    spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
         spi_initialized = true;
     }
 	spi_device_interface_config_t dev_cfg = {
-        .clock_speed_hz = spi->bitrate,     	
-        .mode = spi->clk_mode,                  
-        .queue_size = 8,                        
+        .clock_speed_hz = spi->bitrate,
+        .mode = spi->clk_mode,
+        .queue_size = SPI_QUEUE_SIZE,
+		.spics_io_num = spi_cs_pins[spi->device],
+		.pre_cb = spi_pre_isrs[spi->device],
+		.post_cb = spi_isrs[spi->device],
     };
-    switch(spi->device){
-        case SPI_1:
-            dev_cfg.spics_io_num = PIN_NUM_CS1;
-            transfer_mode_1 = spi->transfer_mode;
-            if(transfer_mode_1 == SPI_INTERRUPT){
-                dev_cfg.post_cb = spi_1_isr;
-            } 
-            spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_1);
-            spi_1_isr_p = spi->func_p;
-            spi_1_user_data = spi->param_p;
-            break;
-        case SPI_2:
-            dev_cfg.spics_io_num = PIN_NUM_CS2;
-            if(transfer_mode_2 == SPI_INTERRUPT){
-                dev_cfg.post_cb = spi_2_isr;
-            } 
-            transfer_mode_1 = spi->transfer_mode;
-            spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_2);
-            spi_2_isr_p = spi->func_p;
-            spi_2_user_data = spi->param_p;
-            break;
-        case SPI_3:
-            dev_cfg.spics_io_num = PIN_NUM_CS3;
-            if(transfer_mode_3 == SPI_INTERRUPT){
-                dev_cfg.post_cb = spi_3_isr;
-            } 
-            transfer_mode_1 = spi->transfer_mode;
-            spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_3);
-            spi_3_isr_p = spi->func_p;
-            spi_3_user_data = spi->param_p;
-            break;
-    }
+	/* Device already added: release it before applying the new configuration */
+	if(dev->handle != NULL){
+		SpiWaitTransfers(spi->device, portMAX_DELAY);
+		spi_bus_remove_device(dev->handle);
+		dev->handle = NULL;
+	}
+	dev->transfer_mode = spi->transfer_mode;
+	dev->isr_p = spi->func_p;
+	dev->user_data = spi->param_p;
+	dev->head = 0;
+	dev->pending = 0;
+	spi_bus_add_device(SPI2_HOST, &dev_cfg, &dev->handle);
     return 0;
 }
 
@@ -108,38 +226,7 @@ void SpiRead(spi_dev_t device, uint8_t * rx_buffer, uint32_t rx_buffer_size){
     t.length = rx_buffer_size * 8;  // tx_buffer_size is in bytes, transaction length is in bits.
     t.rxlength = rx_buffer_size * 8;
     t.rx_buffer = rx_buffer;        // Data
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+	SpiTransmit(device, &t);
 }
 
 void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size){
@@ -147,38 +234,7 @@ void SpiWrite(spi_dev_t device, uint8_t * tx_buffer, uint32_t tx_buffer_size){
     memset(&t, 0, sizeof(t));       // Zero out the transaction
     t.length = tx_buffer_size * 8;  // tx_buffer_size is in bytes, transaction length is in bits.
     t.tx_buffer = tx_buffer;        // Data
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+	SpiTransmit(device, &t);
 }
 
 void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, uint32_t buffer_size){
@@ -187,39 +243,130 @@ void SpiReadWrite(spi_dev_t device, uint8_t * tx_buffer, uint8_t * rx_buffer, ui
     t.length = buffer_size * 8;     // tx_buffer_size is in bytes, transaction length is in bits.
     t.rxlength = buffer_size * 8;
     t.tx_buffer = tx_buffer;        // Data
-    t.rx_buffer = rx_buffer;        
-    switch(device){
-        case SPI_1:
-            switch(transfer_mode_1){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_1, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_1, &t); 
-                    break;
-            }
-            break;
-        case SPI_2:
-            switch(transfer_mode_2){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_2, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_2, &t); 
-                    break;
-            }
-            break;
-        case SPI_3:
-            switch(transfer_mode_3){
-                case SPI_POLLING:
-                    spi_device_polling_transmit(spi_3, &t); 
-                    break;
-                case SPI_INTERRUPT:
-                    spi_device_transmit(spi_3, &t); 
-                    break;
-            }
-            break;
-    }
+    t.rx_buffer = rx_buffer;
+	SpiTransmit(device, &t);
+}
+
+bool SpiQueueTransfer(spi_dev_t device, spi_transfer_t *transfer){
+	spi_dev_data_t *dev = &spi_devs[device];
+	spi_transaction_t *t;
+	uint32_t offset, chunk, chunks;
+	if((dev->handle == NULL) || (transfer->size == 0)){
+		return false;
+	}
+	chunks = (transfer->size + SPI_MAX_CHUNK_SIZE - 1) / SPI_MAX_CHUNK_SIZE;
+	transfer->done = false;
+	transfer->pending = chunks;
+	for(offset = 0; offset < transfer->size; offset += chunk){
+		chunk = transfer->size - offset;
+		if(chunk > SPI_MAX_CHUNK_SIZE){
+			chunk = SPI_MAX_CHUNK_SIZE;
+		}
+		/* Ring full: wait for the oldest transaction to free its slot */
+		if(dev->pending == SPI_QUEUE_SIZE){
+			SpiCollectResult(dev, portMAX_DELAY);
+		}
+		t = &dev->trans[dev->head];
+		memset(t, 0, sizeof(spi_transaction_t));
+		t->length = chunk * 8;
+		if((chunk <= SPI_TXDATA_SIZE) && (transfer->tx_buffer != NULL) && (transfer->rx_buffer == NULL)){
+			/* Short write: bytes travel inside the transaction, no DMA setup */
+			t->flags = SPI_TRANS_USE_TXDATA;
+			memcpy(t->tx_data, transfer->tx_buffer + offset, chunk);
+		} else{
+			t->rxlength = (transfer->rx_buffer != NULL) ? chunk * 8 : 0;
+			t->tx_buffer = (transfer->tx_buffer != NULL) ? transfer->tx_buffer + offset : NULL;
+			t->rx_buffer = (transfer->rx_buffer != NULL) ? transfer->rx_buffer + offset : NULL;
+		}
+		t->user = transfer;
+		if(spi_device_queue_trans(dev->handle, t, portMAX_DELAY) != ESP_OK){
+			/* Chunks not queued will never end */
+			portENTER_CRITICAL(&spi_mux);
+			transfer->pending -= chunks;
+			transfer->done = (transfer->pending == 0);
+			portEXIT_CRITICAL(&spi_mux);
+			return false;
+		}
+		dev->head = (dev->head + 1) % SPI_QUEUE_SIZE;
+		dev->pending++;
+		chunks--;
+	}
+	return true;
+}
+
+void SpiSetDcPin(spi_dev_t device, gpio_t pin){
+	GPIOInit(pin, GPIO_OUTPUT);
+	spi_devs[device].dc_mask = 1UL << pin;
+}
+
+bool SpiWaitTransfers(spi_dev_t device, uint32_t timeout_ms){
+	spi_dev_data_t *dev = &spi_devs[device];
+	TickType_t ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+	while(dev->pending > 0){
+		if(!SpiCollectResult(dev, ticks)){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SpiBufferPoolInit(uint8_t buffer_qty, uint32_t buffer_size){
+	uint8_t *buffer;
+	if(spi_buffer_pool != NULL){
+		return (buffer_size <= spi_buffer_size);
+	}
+	spi_buffer_pool = xQueueCreate(buffer_qty, sizeof(uint8_t *));
+	if(spi_buffer_pool == NULL){
+		return false;
+	}
+	/* Round size up so every buffer keeps the DMA alignment */
+	spi_buffer_size = (buffer_size + SPI_DMA_ALIGN - 1) & ~(SPI_DMA_ALIGN - 1);
+	for(uint8_t i = 0; i < buffer_qty; i++){
+		buffer = heap_caps_aligned_alloc(SPI_DMA_ALIGN, spi_buffer_size, MALLOC_CAP_DMA);
+		if(buffer == NULL){
+			/* All or nothing: free the buffers already allocated */
+			while(xQueueReceive(spi_buffer_pool, &buffer, 0) == pdTRUE){
+				heap_caps_free(buffer);
+			}
+			vQueueDelete(spi_buffer_pool);
+			spi_buffer_pool = NULL;
+			spi_buffer_size = 0;
+			return false;
+		}
+		xQueueSend(spi_buffer_pool, &buffer, 0);
+	}
+	spi_buffer_qty = buffer_qty;
+	return true;
+}
+
+uint8_t * SpiBufferGet(uint32_t timeout_ms){
+	uint8_t *buffer = NULL;
+	TickType_t ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+	if(spi_buffer_pool != NULL){
+		xQueueReceive(spi_buffer_pool, &buffer, ticks);
+	}
+	return buffer;
+}
+
+void SpiBufferRelease(uint8_t * buffer){
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	if((spi_buffer_pool == NULL) || (buffer == NULL)){
+		return;
+	}
+	if(xPortInIsrContext()){
+		xQueueSendFromISR(spi_buffer_pool, &buffer, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	} else{
+		xQueueSend(spi_buffer_pool, &buffer, 0);
+	}
+}
+
+uint32_t SpiBufferSize(void){
+	return spi_buffer_size;
+}
+
+uint8_t SpiBufferQty(void){
+	return spi_buffer_qty;
 }
 
 uint8_t SpiDeInit(spi_dev_t device){
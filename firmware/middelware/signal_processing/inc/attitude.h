@@ -0,0 +1,91 @@
+#ifndef ATTITUDE_H_
+#define ATTITUDE_H_
+/** \addtogroup Drivers_Programable Drivers Programable
+ ** @{ */
+/** \addtogroup Middelware Middelware
+ ** @{ */
+/** \addtogroup Attitude Attitude estimation
+ ** @{ */
+
+/** \brief Orientation estimation from gyroscope and accelerometer samples
+ * 
+ * Complementary, Madgwick and Mahony filters. Each filter keeps its state in an
+ * attitude_t struct owned by the application (no dynamic memory), and each sample
+ * costs a fixed number of operations, so it can run at the IMU sample rate.
+ * 
+ * @note Yaw is not observable without a magnetometer: it only integrates the gyroscope.
+ * 
+ * Golden trajectory tests and a benchmark run on the host: see test/test_attitude.c.
+ * 
+ * @author Eric Beauchamps
+ *
+ * @section changelog
+ *
+ * |   Date	    | Description                                    						|
+ * |:----------:|:----------------------------------------------------------------------|
+ * | 19/10/2026 | Document creation		                         						|
+ * 
+ **/
+
+/*==================[inclusions]=============================================*/
+#include <stdint.h>
+#include <stdbool.h>
+/*==================[macros]=================================================*/
+
+/*==================[typedef]================================================*/
+typedef enum attitude_filter {
+    ATTITUDE_COMPLEMENTARY,     /*!< Gyro integration with a fixed fraction of accelerometer tilt correction */
+    ATTITUDE_MADGWICK,          /*!< Madgwick gradient descent filter */
+    ATTITUDE_MAHONY             /*!< Mahony PI filter (corrects gyro bias) */
+} attitude_filter_t;
+
+typedef struct {
+    attitude_filter_t type;     /*!< Filter type */
+    float gain;                 /*!< Complementary: accel weight per sample (e.g. 0.02), Madgwick: beta (e.g. 0.1), Mahony: Kp (e.g. 1) */
+    float gain_i;               /*!< Mahony: Ki (e.g. 0.5, removes a gyro bias in a few seconds), not used by other filters */
+    float q[4];                 /*!< Orientation quaternion (w, x, y, z) */
+    float integral[3];          /*!< Mahony integral error (gyro bias estimation) */
+    int64_t last_us;            /*!< Last sample time */
+    bool initialized;           /*!< A first sample has set roll, pitch and last_us */
+} attitude_t;
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+/**
+ * @brief Initialize an attitude filter
+ * 
+ * @param att       Filter state
+ * @param type      Filter type
+ * @param gain      Filter gain (see attitude_t)
+ * @param gain_i    Integral gain (only Mahony)
+ */
+void AttitudeInit(attitude_t * att, attitude_filter_t type, float gain, float gain_i);
+
+/**
+ * @brief Update the orientation with a new sample
+ * 
+ * @note The first sample sets roll and pitch from the accelerometer.
+ * 
+ * @param att       Filter state
+ * @param gyro      Angular rate (x, y, z) in rad/s
+ * @param accel     Acceleration (x, y, z) in any unit (only its direction is used)
+ * @param time_us   Sample time in us (e.g. mpu6050_sample_t time_us)
+ */
+void AttitudeUpdate(attitude_t * att, const float * gyro, const float * accel, int64_t time_us);
+
+/**
+ * @brief Orientation as Euler angles (Z-Y-X sequence)
+ * 
+ * @param att       Filter state
+ * @param roll      Rotation around x in degrees
+ * @param pitch     Rotation around y in degrees
+ * @param yaw       Rotation around z in degrees
+ */
+void AttitudeEuler(const attitude_t * att, float * roll, float * pitch, float * yaw);
+
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+/** @} doxygen end group definition */
+#endif /* ATTITUDE_H_ */
+
+/*==================[end of file]============================================*/
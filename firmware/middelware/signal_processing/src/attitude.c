@@ -0,0 +1,182 @@
+/**
+ * @file attitude.c
+ * @author Eric Beauchamps (beauchampseric97@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+/*==================[inclusions]=============================================*/
+#include <math.h>
+#include "attitude.h"
+/*==================[macros and definitions]=================================*/
+#define RAD2DEG         57.29578f
+#define MAX_DT          0.1f        // longer gaps (lost samples) are not integrated
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Normalize a vector, returns false if it is null
+ */
+static int AttitudeNormalize(float * v, uint8_t n){
+    float norm = 0;
+    for(uint8_t i = 0; i < n; i++){
+        norm += v[i] * v[i];
+    }
+    if(norm == 0){
+        return 0;
+    }
+    norm = 1.0f / sqrtf(norm);
+    for(uint8_t i = 0; i < n; i++){
+        v[i] *= norm;
+    }
+    return 1;
+}
+
+/**
+ * @brief Integrate angular rate w (rad/s) during dt: q += 0.5 * q x (0, w) * dt
+ */
+static void AttitudeIntegrate(float * q, const float * w, float dt){
+    float qw = q[0], qx = q[1], qy = q[2], qz = q[3];
+    float h = 0.5f * dt;
+    q[0] += h * (-qx * w[0] - qy * w[1] - qz * w[2]);
+    q[1] += h * ( qw * w[0] + qy * w[2] - qz * w[1]);
+    q[2] += h * ( qw * w[1] - qx * w[2] + qz * w[0]);
+    q[3] += h * ( qw * w[2] + qx * w[1] - qy * w[0]);
+}
+
+/**
+ * @brief Error between measured gravity direction a and estimated one: a x v
+ */
+static void AttitudeGravityError(const float * q, const float * a, float * e){
+    float v[3];
+    v[0] = 2 * (q[1] * q[3] - q[0] * q[2]);
+    v[1] = 2 * (q[0] * q[1] + q[2] * q[3]);
+    v[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+    e[0] = a[1] * v[2] - a[2] * v[1];
+    e[1] = a[2] * v[0] - a[0] * v[2];
+    e[2] = a[0] * v[1] - a[1] * v[0];
+}
+
+/**
+ * @brief Madgwick IMU update (gradient descent step on the gravity error)
+ */
+static void AttitudeMadgwick(attitude_t * att, const float * g, const float * a, float dt){
+    float * q = att->q;
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    float f[3], s[4], q_dot[4];
+    q_dot[0] = 0.5f * (-q1 * g[0] - q2 * g[1] - q3 * g[2]);
+    q_dot[1] = 0.5f * ( q0 * g[0] + q2 * g[2] - q3 * g[1]);
+    q_dot[2] = 0.5f * ( q0 * g[1] - q1 * g[2] + q3 * g[0]);
+    q_dot[3] = 0.5f * ( q0 * g[2] + q1 * g[1] - q2 * g[0]);
+    /* Objective function and its gradient (J^T * f) */
+    f[0] = 2 * (q1 * q3 - q0 * q2) - a[0];
+    f[1] = 2 * (q0 * q1 + q2 * q3) - a[1];
+    f[2] = 2 * (0.5f - q1 * q1 - q2 * q2) - a[2];
+    s[0] = -2 * q2 * f[0] + 2 * q1 * f[1];
+    s[1] =  2 * q3 * f[0] + 2 * q0 * f[1] - 4 * q1 * f[2];
+    s[2] = -2 * q0 * f[0] + 2 * q3 * f[1] - 4 * q2 * f[2];
+    s[3] =  2 * q1 * f[0] + 2 * q2 * f[1];
+    if(AttitudeNormalize(s, 4)){
+        for(uint8_t i = 0; i < 4; i++){
+            q_dot[i] -= att->gain * s[i];
+        }
+    }
+    for(uint8_t i = 0; i < 4; i++){
+        q[i] += q_dot[i] * dt;
+    }
+}
+
+/*==================[external functions definition]==========================*/
+void AttitudeInit(attitude_t * att, attitude_filter_t type, float gain, float gain_i){
+    att->type = type;
+    att->gain = gain;
+    att->gain_i = gain_i;
+    att->q[0] = 1;
+    att->q[1] = att->q[2] = att->q[3] = 0;
+    att->integral[0] = att->integral[1] = att->integral[2] = 0;
+    att->last_us = 0;
+    att->initialized = false;
+}
+
+void AttitudeUpdate(attitude_t * att, const float * gyro, const float * accel, int64_t time_us){
+    float a[3] = {accel[0], accel[1], accel[2]};
+    float w[3] = {gyro[0], gyro[1], gyro[2]};
+    float e[3], dt;
+    int accel_ok = AttitudeNormalize(a, 3);
+
+    if(!att->initialized){
+        /* Initial roll and pitch from gravity, yaw = 0 */
+        if(accel_ok){
+            float roll = atan2f(a[1], a[2]) / 2;
+            float pitch = atan2f(-a[0], sqrtf(a[1] * a[1] + a[2] * a[2])) / 2;
+            att->q[0] = cosf(roll) * cosf(pitch);
+            att->q[1] = sinf(roll) * cosf(pitch);
+            att->q[2] = cosf(roll) * sinf(pitch);
+            att->q[3] = -sinf(roll) * sinf(pitch);
+        }
+        att->last_us = time_us;
+        att->initialized = true;
+        return;
+    }
+    dt = (time_us - att->last_us) * 1e-6f;
+    att->last_us = time_us;
+    if(dt <= 0 || dt > MAX_DT){
+        return;
+    }
+    switch(att->type){
+        case ATTITUDE_COMPLEMENTARY:
+            AttitudeIntegrate(att->q, w, dt);
+            if(accel_ok){
+                /* Rotate a fixed fraction of the tilt error per sample */
+                AttitudeNormalize(att->q, 4);
+                AttitudeGravityError(att->q, a, e);
+                AttitudeIntegrate(att->q, e, att->gain);
+            }
+        break;
+        case ATTITUDE_MADGWICK:
+            if(accel_ok){
+                AttitudeMadgwick(att, w, a, dt);
+            }
+            else{
+                AttitudeIntegrate(att->q, w, dt);
+            }
+        break;
+        case ATTITUDE_MAHONY:
+            if(accel_ok){
+                AttitudeGravityError(att->q, a, e);
+                for(uint8_t i = 0; i < 3; i++){
+                    att->integral[i] += att->gain_i * e[i] * dt;
+                    w[i] += att->gain * e[i] + att->integral[i];
+                }
+            }
+            AttitudeIntegrate(att->q, w, dt);
+        break;
+    }
+    AttitudeNormalize(att->q, 4);
+}
+
+void AttitudeEuler(const attitude_t * att, float * roll, float * pitch, float * yaw){
+    const float * q = att->q;
+    float sin_pitch = 2 * (q[0] * q[2] - q[3] * q[1]);
+    if(sin_pitch > 1){
+        sin_pitch = 1;
+    }
+    else if(sin_pitch < -1){
+        sin_pitch = -1;
+    }
+    *roll = atan2f(2 * (q[0] * q[1] + q[2] * q[3]), 1 - 2 * (q[1] * q[1] + q[2] * q[2])) * RAD2DEG;
+    *pitch = asinf(sin_pitch) * RAD2DEG;
+    *yaw = atan2f(2 * (q[0] * q[3] + q[1] * q[2]), 1 - 2 * (q[2] * q[2] + q[3] * q[3])) * RAD2DEG;
+}
+
+/*==================[end of file]============================================*/
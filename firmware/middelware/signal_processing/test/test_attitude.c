@@ -0,0 +1,213 @@
+/**
+ * @file test_attitude.c
+ * @author Eric Beauchamps (beauchampseric97@gmail.com)
+ * @brief Host tests and benchmark of the attitude filters
+ * 
+ * Golden trajectories are generated analytically: the true orientation is known at every
+ * sample, gyro and accelerometer samples are derived from it (plus bias and noise) and the
+ * filter output is compared with it. The benchmark measures the cost of AttitudeUpdate().
+ * 
+ * Build and run on the host (no ESP-IDF needed):
+ * 
+ *     cmake -S firmware/middelware/signal_processing/test -B build_test
+ *     cmake --build build_test && ctest --test-dir build_test --output-on-failure
+ * 
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "attitude.h"
+/*==================[macros and definitions]=================================*/
+#define PI              3.14159265358979f
+#define DEG2RAD         (PI / 180.0f)
+#define RATE_HZ         1000        // samples per second
+#define DURATION_S      60          // trajectory length
+#define SETTLE_S        20          // errors are checked after this time
+#define BENCH_SAMPLES   1000000
+#define BIAS_TOLERANCE  0.002f      // Mahony x/y gyro bias estimation error (rad/s)
+
+/**
+ * @brief Golden trajectory: Euler angles (rad) as a function of time, plus sensor errors
+ */
+typedef struct {
+    const char * name;
+    float roll_amp, roll_hz;        /*!< Roll = roll_amp * sin(2 pi roll_hz t) + roll_off */
+    float roll_off;
+    float pitch_amp, pitch_hz;      /*!< Pitch = pitch_amp * sin(2 pi pitch_hz t) + pitch_off */
+    float pitch_off;
+    float yaw_rate;                 /*!< Yaw = yaw_rate * t */
+    float gyro_bias[3];             /*!< Constant gyro error (rad/s) */
+    float gyro_noise;               /*!< Gyro noise standard deviation (rad/s) */
+    float accel_noise;              /*!< Accelerometer noise standard deviation (g) */
+} trajectory_t;
+
+/**
+ * @brief Filter under test and maximum roll/pitch error (deg) for each trajectory
+ */
+typedef struct {
+    const char * name;
+    attitude_filter_t type;
+    float gain, gain_i;
+    float max_error[4];
+} filter_case_t;
+/*==================[internal data definition]===============================*/
+static const trajectory_t trajectories[] = {
+    {"static tilt", 0, 0, 20 * DEG2RAD, 0, 0, -10 * DEG2RAD, 0, {0, 0, 0}, 0, 0},
+    {"roll/pitch swing", 30 * DEG2RAD, 0.5f, 0, 20 * DEG2RAD, 0.3f, 0, 0.2f, {0, 0, 0}, 0.002f, 0.005f},
+    {"swing + gyro bias", 30 * DEG2RAD, 0.5f, 0, 20 * DEG2RAD, 0.3f, 0, 0.2f, {0.02f, -0.02f, 0.02f}, 0.002f, 0.005f},
+    {"fast joint motion", 60 * DEG2RAD, 2.0f, 0, 45 * DEG2RAD, 1.5f, 0, 0, {0.01f, 0.01f, 0}, 0.005f, 0.01f},
+};
+
+static const filter_case_t filters[] = {
+    /* Gains are the examples of attitude_t, limits about 1.5 times the measured errors */
+    {"complementary", ATTITUDE_COMPLEMENTARY, 0.02f, 0,     {0.05f, 0.20f, 0.30f, 0.70f}},
+    {"madgwick",      ATTITUDE_MADGWICK,      0.1f,  0,     {0.05f, 0.30f, 0.40f, 1.30f}},
+    {"mahony",        ATTITUDE_MAHONY,        1.0f,  0.5f,  {0.05f, 0.12f, 0.32f, 0.65f}},
+};
+
+static uint32_t rng_state;
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Deterministic gaussian noise (LCG + Box-Muller), same on every host
+ */
+static float Noise(float sigma){
+    float u1, u2;
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u1 = ((rng_state >> 8) + 1) / 16777217.0f;
+    rng_state = rng_state * 1664525u + 1013904223u;
+    u2 = (rng_state >> 8) / 16777216.0f;
+    return sigma * sqrtf(-2 * logf(u1)) * cosf(2 * PI * u2);
+}
+
+/**
+ * @brief True angles (rad) and their derivatives at time t
+ */
+static void TrajectoryAt(const trajectory_t * tr, float t, float * angle, float * rate){
+    float wr = 2 * PI * tr->roll_hz, wp = 2 * PI * tr->pitch_hz;
+    angle[0] = tr->roll_amp * sinf(wr * t) + tr->roll_off;
+    angle[1] = tr->pitch_amp * sinf(wp * t) + tr->pitch_off;
+    angle[2] = tr->yaw_rate * t;
+    rate[0] = tr->roll_amp * wr * cosf(wr * t);
+    rate[1] = tr->pitch_amp * wp * cosf(wp * t);
+    rate[2] = tr->yaw_rate;
+}
+
+/**
+ * @brief Ideal IMU samples for the given angles: body rates (rad/s) and gravity (g)
+ */
+static void ImuSample(const float * angle, const float * rate, float * gyro, float * accel){
+    float sr = sinf(angle[0]), cr = cosf(angle[0]);
+    float sp = sinf(angle[1]), cp = cosf(angle[1]);
+    gyro[0] = rate[0] - rate[2] * sp;
+    gyro[1] = rate[1] * cr + rate[2] * cp * sr;
+    gyro[2] = -rate[1] * sr + rate[2] * cp * cr;
+    accel[0] = -sp;
+    accel[1] = sr * cp;
+    accel[2] = cr * cp;
+}
+
+/**
+ * @brief Wrap an angle difference to [-180, 180) degrees
+ */
+static float AngleError(float a, float b){
+    float e = fmodf(a - b + 540.0f, 360.0f) - 180.0f;
+    return fabsf(e);
+}
+
+/**
+ * @brief Run a filter over a trajectory, returns the max roll/pitch error after SETTLE_S
+ * and the final filter state in att
+ */
+static float RunTrajectory(const filter_case_t * fc, const trajectory_t * tr, attitude_t * att_out){
+    attitude_t att;
+    float angle[3], rate[3], gyro[3], accel[3];
+    float roll, pitch, yaw, error, max_error = 0;
+    rng_state = 12345;
+    AttitudeInit(&att, fc->type, fc->gain, fc->gain_i);
+    for(uint32_t n = 0; n <= DURATION_S * RATE_HZ; n++){
+        float t = (float)n / RATE_HZ;
+        TrajectoryAt(tr, t, angle, rate);
+        ImuSample(angle, rate, gyro, accel);
+        for(uint8_t i = 0; i < 3; i++){
+            gyro[i] += tr->gyro_bias[i] + Noise(tr->gyro_noise);
+            accel[i] += Noise(tr->accel_noise);
+        }
+        AttitudeUpdate(&att, gyro, accel, (int64_t)n * 1000000 / RATE_HZ);
+        if(t >= SETTLE_S){
+            AttitudeEuler(&att, &roll, &pitch, &yaw);
+            error = fmaxf(AngleError(roll, angle[0] / DEG2RAD), AngleError(pitch, angle[1] / DEG2RAD));
+            max_error = fmaxf(max_error, error);
+        }
+    }
+    *att_out = att;
+    return max_error;
+}
+
+/**
+ * @brief Time per AttitudeUpdate() call in ns
+ */
+static double Benchmark(const filter_case_t * fc){
+    attitude_t att;
+    float gyro[3] = {0.1f, -0.2f, 0.05f}, accel[3] = {0.1f, 0.2f, 0.97f};
+    struct timespec start, end;
+    AttitudeInit(&att, fc->type, fc->gain, fc->gain_i);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(uint32_t n = 0; n < BENCH_SAMPLES; n++){
+        accel[0] = -accel[0];   // keep the compiler from hoisting the work
+        AttitudeUpdate(&att, gyro, accel, (int64_t)n * 1000);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if(att.q[0] != att.q[0]){
+        return -1;
+    }
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / BENCH_SAMPLES;
+}
+
+/*==================[external functions definition]==========================*/
+int main(int argc, char ** argv){
+    int failures = 0;
+    int bench = (argc > 1) && (strcmp(argv[1], "--bench") == 0);
+    uint8_t qty = sizeof(trajectories) / sizeof(trajectories[0]);
+
+    if(bench){
+        printf("AttitudeUpdate() cost (ns per sample)\n");
+        for(uint8_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++){
+            double ns = Benchmark(&filters[f]);
+            printf("  %-14s %8.1f\n", filters[f].name, ns);
+            failures += (ns < 0);
+        }
+        return failures ? 1 : 0;
+    }
+    printf("Max roll/pitch error after %d s of %d s at %d Hz (deg)\n", SETTLE_S, DURATION_S, RATE_HZ);
+    for(uint8_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++){
+        for(uint8_t i = 0; i < qty; i++){
+            attitude_t att;
+            float error = RunTrajectory(&filters[f], &trajectories[i], &att);
+            int ok = error <= filters[f].max_error[i];
+            printf("  %-14s %-18s %6.3f (limit %.2f) %s\n", filters[f].name, trajectories[i].name,
+                   error, filters[f].max_error[i], ok ? "ok" : "FAIL");
+            failures += !ok;
+            /* The integral converges to minus the bias (z is not seen by the accelerometer while level) */
+            if(filters[f].type == ATTITUDE_MAHONY){
+                for(uint8_t j = 0; j < 2; j++){
+                    if(fabsf(att.integral[j] + trajectories[i].gyro_bias[j]) > BIAS_TOLERANCE){
+                        printf("  %-14s %-18s bias[%d] estimate %.4f, expected %.4f FAIL\n", filters[f].name,
+                               trajectories[i].name, j, -att.integral[j], trajectories[i].gyro_bias[j]);
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,258 @@
+/**
+ * @file test_qoi.c
+ * @author Eric Beauchamps (beauchampseric97@gmail.com)
+ * @brief Host tests of the streaming QOI decoder used by ILI9341DrawQoi()
+ *
+ * RGBA source images are encoded with a reference QOI encoder
+ * (https://qoiformat.org/qoi-specification.pdf) and decoded back with QoiDecode() in
+ * strips of several sizes, as ILI9341DrawQoi() does with its DMA buffers. Every decoded
+ * pixel must be equal to the RGB565 conversion of the source one, and every kind of
+ * QOI chunk must be used by the images.
+ *
+ * Build and run on the host (no ESP-IDF needed):
+ *
+ *     cmake -S firmware/middelware/signal_processing/test -B build_test
+ *     cmake --build build_test && ctest --test-dir build_test --output-on-failure
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/*==================[inclusions]=============================================*/
+#include <stdio.h>
+#include <string.h>
+#include "qoi.h"
+/*==================[macros and definitions]=================================*/
+#define MAX_PIXELS      (240 * 320)
+#define MAX_QOI_SIZE    (QOI_HEADER_SIZE + MAX_PIXELS * 5 + QOI_PADDING)
+#define CHUNK_QTY       6           // index, diff, luma, run, rgb, rgba
+
+/**
+ * @brief Source image: generated RGBA pixels (alpha is ignored by the LCD)
+ */
+typedef struct {
+    const char * name;
+    uint16_t width, height;
+    void (*generate)(uint16_t width, uint16_t height, uint8_t (*rgba)[4]);
+} image_case_t;
+/*==================[internal functions declaration]=========================*/
+static void Gradient(uint16_t width, uint16_t height, uint8_t (*rgba)[4]);
+static void Noise(uint16_t width, uint16_t height, uint8_t (*rgba)[4]);
+static void FlatRuns(uint16_t width, uint16_t height, uint8_t (*rgba)[4]);
+static void Palette(uint16_t width, uint16_t height, uint8_t (*rgba)[4]);
+/*==================[internal data definition]===============================*/
+static const image_case_t images[] = {
+    /* Each image exercises mostly one kind of QOI chunk */
+    {"gradient (diff, luma)", 97, 53, Gradient},
+    {"wide gradient", 240, 20, Gradient},
+    {"noise (rgb, rgba)", 61, 37, Noise},
+    {"flat runs (run)", 240, 4, FlatRuns},
+    {"palette (index)", 50, 50, Palette},
+    {"single pixel", 1, 1, Noise},
+};
+
+/* Pixels per QoiDecode() call (0: the whole image at once) */
+static const uint32_t strips[] = {1, 7, 62, 63, 64, 97 * 5 + 3, 4096, 0};
+
+static const char * chunk_names[CHUNK_QTY] = {"index", "diff", "luma", "run", "rgb", "rgba"};
+static uint32_t chunks[CHUNK_QTY];          /*!< Chunks of each kind written by QoiEncode() */
+static uint8_t source[MAX_PIXELS][4];
+static uint8_t qoi[MAX_QOI_SIZE];
+static uint8_t decoded[MAX_PIXELS * 2];
+static uint32_t rng_state;
+/*==================[internal functions definition]==========================*/
+/**
+ * @brief Deterministic pseudo random numbers (LCG), same on every host
+ */
+static uint32_t Random(void){
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static void Gradient(uint16_t width, uint16_t height, uint8_t (*rgba)[4]){
+    for(uint32_t y = 0; y < height; y++){
+        for(uint32_t x = 0; x < width; x++){
+            uint8_t * px = rgba[y * width + x];
+            px[0] = x * 255 / width;
+            px[1] = (x + y) * 255 / (width + height);
+            px[2] = y * 255 / height;
+            px[3] = 255;
+        }
+    }
+}
+
+static void Noise(uint16_t width, uint16_t height, uint8_t (*rgba)[4]){
+    rng_state = 12345;
+    for(uint32_t i = 0; i < (uint32_t)width * height; i++){
+        rgba[i][0] = Random();
+        rgba[i][1] = Random();
+        rgba[i][2] = Random();
+        /* Some alpha changes, encoded as RGBA chunks */
+        rgba[i][3] = ((Random() & 0x0F) == 0) ? Random() : 255;
+    }
+}
+
+static void FlatRuns(uint16_t width, uint16_t height, uint8_t (*rgba)[4]){
+    uint32_t color = 0;
+    rng_state = 777;
+    for(uint32_t i = 0; i < (uint32_t)width * height; i++){
+        /* Runs longer than 62 pixels are split in several chunks */
+        if(Random() % 150 == 0){
+            color = Random();
+        }
+        rgba[i][0] = color;
+        rgba[i][1] = color >> 8;
+        rgba[i][2] = color >> 16;
+        rgba[i][3] = 255;
+    }
+}
+
+static void Palette(uint16_t width, uint16_t height, uint8_t (*rgba)[4]){
+    static const uint8_t colors[][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255},
+                                        {0, 0, 0}, {255, 255, 0}, {128, 128, 128}, {64, 64, 64}};
+    rng_state = 4242;
+    for(uint32_t i = 0; i < (uint32_t)width * height; i++){
+        memcpy(rgba[i], colors[Random() % (sizeof(colors) / sizeof(colors[0]))], 3);
+        rgba[i][3] = 255;
+    }
+}
+
+/**
+ * @brief Reference QOI encoder, returns the image size in bytes
+ */
+static uint32_t QoiEncode(const uint8_t (*rgba)[4], uint16_t width, uint16_t height, uint8_t * out){
+    uint8_t index[64][4] = {{0}};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    const uint8_t * px;
+    uint32_t pixels = (uint32_t)width * height, n = 0, run = 0;
+
+    memcpy(out, "qoif", 4);
+    out[4] = 0; out[5] = 0; out[6] = width >> 8; out[7] = width & 0xFF;
+    out[8] = 0; out[9] = 0; out[10] = height >> 8; out[11] = height & 0xFF;
+    out[12] = 4;    // channels
+    out[13] = 0;    // sRGB
+    n = QOI_HEADER_SIZE;
+    for(uint32_t i = 0; i < pixels; i++){
+        px = rgba[i];
+        if(memcmp(px, prev, 4) == 0){
+            run++;
+            if((run == 62) || (i == pixels - 1)){
+                out[n++] = 0xC0 | (run - 1);
+                chunks[3]++;
+                run = 0;
+            }
+            continue;
+        }
+        if(run > 0){
+            out[n++] = 0xC0 | (run - 1);
+            chunks[3]++;
+            run = 0;
+        }
+        uint8_t h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if(memcmp(index[h], px, 4) == 0){
+            out[n++] = h;
+            chunks[0]++;
+        }
+        else{
+            memcpy(index[h], px, 4);
+            if(px[3] == prev[3]){
+                int8_t dr = px[0] - prev[0], dg = px[1] - prev[1], db = px[2] - prev[2];
+                int8_t dr_dg = dr - dg, db_dg = db - dg;
+                if((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1)){
+                    out[n++] = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+                    chunks[1]++;
+                }
+                else if((dg >= -32) && (dg <= 31) && (dr_dg >= -8) && (dr_dg <= 7) && (db_dg >= -8) && (db_dg <= 7)){
+                    out[n++] = 0x80 | (dg + 32);
+                    out[n++] = ((dr_dg + 8) << 4) | (db_dg + 8);
+                    chunks[2]++;
+                }
+                else{
+                    out[n++] = 0xFE;
+                    memcpy(&out[n], px, 3);
+                    n += 3;
+                    chunks[4]++;
+                }
+            }
+            else{
+                out[n++] = 0xFF;
+                memcpy(&out[n], px, 4);
+                n += 4;
+                chunks[5]++;
+            }
+        }
+        memcpy(prev, px, 4);
+    }
+    memset(&out[n], 0, QOI_PADDING - 1);
+    out[n + QOI_PADDING - 1] = 1;
+    return n + QOI_PADDING;
+}
+
+/**
+ * @brief Decode an image in strips of strip pixels, returns the number of wrong pixels
+ */
+static uint32_t DecodeStrips(const uint8_t * image, uint32_t size, uint32_t pixels, uint32_t strip){
+    qoi_decoder_t dec;
+    uint32_t done, n, bad = 0;
+
+    if(!QoiDecoderInit(&dec, image, size)){
+        return pixels;
+    }
+    if(strip == 0){
+        strip = pixels;
+    }
+    /* Poison the output, so pixels that are not written are not equal by chance */
+    memset(decoded, 0xA5, sizeof(decoded));
+    for(done = 0; done < pixels; done += n){
+        n = (pixels - done < strip) ? pixels - done : strip;
+        QoiDecode(&dec, &decoded[done * 2], n);
+    }
+    for(uint32_t i = 0; i < pixels; i++){
+        uint16_t color = (decoded[2 * i] << 8) | decoded[2 * i + 1];
+        uint16_t expected = ((source[i][0] & 0xF8) << 8) | ((source[i][1] & 0xFC) << 3) | (source[i][2] >> 3);
+        bad += (color != expected);
+    }
+    return bad;
+}
+
+/*==================[external functions definition]==========================*/
+int main(void){
+    int failures = 0;
+    uint32_t width, height;
+
+    printf("Wrong pixels decoding QOI images in strips\n");
+    for(uint8_t i = 0; i < sizeof(images) / sizeof(images[0]); i++){
+        const image_case_t * img = &images[i];
+        uint32_t pixels = (uint32_t)img->width * img->height;
+        uint32_t size;
+        img->generate(img->width, img->height, source);
+        size = QoiEncode((const uint8_t (*)[4])source, img->width, img->height, qoi);
+        if(!QoiGetSize(qoi, size, &width, &height) || (width != img->width) || (height != img->height)){
+            printf("  %-22s header FAIL\n", img->name);
+            failures++;
+            continue;
+        }
+        for(uint8_t s = 0; s < sizeof(strips) / sizeof(strips[0]); s++){
+            uint32_t bad = DecodeStrips(qoi, size, pixels, strips[s]);
+            printf("  %-22s %3ux%-3u %5u bytes, strip %5u: %u %s\n", img->name, img->width, img->height,
+                   size, strips[s] ? strips[s] : pixels, bad, bad ? "FAIL" : "ok");
+            failures += (bad != 0);
+        }
+    }
+    for(uint8_t c = 0; c < CHUNK_QTY; c++){
+        printf("  %-5s chunks: %6u %s\n", chunk_names[c], chunks[c], chunks[c] ? "ok" : "FAIL");
+        failures += (chunks[c] == 0);
+    }
+    /* Invalid images are rejected */
+    memcpy(qoi, "qoix", 4);
+    if(QoiGetSize(qoi, QOI_HEADER_SIZE + QOI_PADDING, &width, &height) || QoiGetSize(qoi, 10, &width, &height)){
+        printf("  invalid header accepted FAIL\n");
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
+
+/*==================[end of file]============================================*/
@@ -26,6 +26,7 @@
  * | 22/03/2024 | Se crea el documento	                         |
  * | 22/03/2024 | Se documenta	                         		 |
  * | 01/04/2024 | Se finaliza la documentacion	                 |
+ * | 19/10/2026 | Pines BCD escritos juntos con GPIOWriteMask	 |
  * 
  * @author Eric Beauchamps (beauchampseric97@gmail.com)
  *
@@ -75,27 +76,12 @@ void  ConvertToBcdArray (uint32_t data, uint8_t digits, uint8_t * bcd_number)
 /** 
  * @brief Permite manipular el estado de los pines para la codificacion.
  * @param BCD Dato decimal ya codificado que se desea mostrar.
- * @param Pines Puntero que almacena los pines del numero que se desea mostrar.
+ * @param Pines Grupo de pines del numero que se desea mostrar (se escriben todos juntos).
  */
 
-void ManipularEstadoPinCodificacion(uint BCD, gpioConf_t *Pines)
+void ManipularEstadoPinCodificacion(uint BCD, gpio_mask_t *Pines)
 {
-	for(uint8_t i = 0; i<4;i++)
-	{
-		GPIOInit(Pines[i].pin, Pines[i].dir); //Inicializo los pines de codificacion
-	}
-
-	for(uint8_t i = 0; i<4;i++)	
-	{
-		if((BCD >> i) & 1) //(BCD & 1<<i) es equivalente en resultado
-		{
-			GPIOOn(Pines[i].pin);
-		}
-		else
-		{
-			GPIOOff(Pines[i].pin);
-		}
-	}
+	GPIOWriteMask(Pines, BCD); //El bit i de BCD corresponde al pin i del grupo
 };
 
 /**
@@ -103,21 +89,16 @@ void ManipularEstadoPinCodificacion(uint BCD, gpioConf_t *Pines)
  * @param data Dato decimal de 32 bits.
  * @param digits Cantidad de digitos a codificar.
  * @param bcd_number Puntero de un vector que almacena los datos una vez que han sido codificados.
- * @param PinesCodificacion Puntero de un vector que almacena los pines del numero que se desea mostrar.
+ * @param PinesCodificacion Grupo de pines del numero que se desea mostrar.
  * @param PinesDigitos Puntero de un vector que almacena los pines del digito que se desea mostrar.
  * 
  */
 
-void ManipularDisplayLCD(uint32_t data, uint8_t digits, gpioConf_t *PinesCodificacion, gpioConf_t *PinesDigitos, uint8_t * bcd_number)
+void ManipularDisplayLCD(uint32_t data, uint8_t digits, gpio_mask_t *PinesCodificacion, gpioConf_t *PinesDigitos, uint8_t * bcd_number)
 {
-	for(uint8_t i = 0; i<4;i++)
-	{
-		GPIOInit(PinesDigitos[i].pin, PinesDigitos[i].dir); //Inicializo los pines que controlan los digitos
-	}
-
 	ConvertToBcdArray(data, digits, bcd_number);
 
-	for(uint8_t i = 0; i<3;i++)
+	for(uint8_t i = 0; i<digits;i++)
 	{
 		GPIOOff(PinesDigitos[i].pin);
 		ManipularEstadoPinCodificacion (bcd_number[i], PinesCodificacion);
@@ -130,6 +111,8 @@ void ManipularDisplayLCD(uint32_t data, uint8_t digits, gpioConf_t *PinesCodific
 void app_main(void)
 {
 	gpioConf_t PinCodificacion[4];
+	gpio_t ListaPinesCodificacion[4];
+	gpio_mask_t GrupoCodificacion; //Pines de codificacion escritos todos juntos
 	gpioConf_t PinDigito[3];
 	gpioConf_t PinBuzer; //Defino pin para buzer (no es necesario para resolucion del ejercio)
 
@@ -155,6 +138,18 @@ void app_main(void)
 	PinDigito[2].pin = GPIO_19;
 	PinDigito[2].dir = GPIO_OUTPUT;
 
+	//Inicializo los pines una sola vez
+	for(uint8_t i = 0; i<4;i++)
+	{
+		GPIOInit(PinCodificacion[i].pin, PinCodificacion[i].dir);
+		ListaPinesCodificacion[i] = PinCodificacion[i].pin;
+	}
+	GPIOMaskInit(&GrupoCodificacion, ListaPinesCodificacion, 4);
+	for(uint8_t i = 0; i<3;i++)
+	{
+		GPIOInit(PinDigito[i].pin, PinDigito[i].dir);
+	}
+
 	//Configuro pin para buzer (no es necesario para resolucion del ejercio)
 	PinBuzer.pin = GPIO_3;
 	PinBuzer.dir = GPIO_OUTPUT;
@@ -171,7 +166,7 @@ void app_main(void)
 	else
 	{
 	//Funcion para controlar los pines que permiten la visualizacion 
-	ManipularDisplayLCD(Dato, CantidadDigitos, PinCodificacion, PinDigito, NumeroBCD);
+	ManipularDisplayLCD(Dato, CantidadDigitos, &GrupoCodificacion, PinDigito, NumeroBCD);
 	}
 }
 